@@ -0,0 +1,236 @@
+/** Drives one shared Mmu and PageTable from several threads at once, each thread owning its own simulated processes,
+    and reports how command throughput scales with the number of threads **/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "commands.h"
+#include "mmu.h"
+#include "pagetable.h"
+#include "physicalmemory.h"
+#include "tlb.h"
+#include "swapfile.h"
+#include "replacement.h"
+
+/** Workload shape shared by every thread **/
+typedef struct DriverConfig {
+    uint32_t processes;     // processes created by each thread
+    uint64_t commands;      // commands run by each thread, not counting create and terminate
+    uint32_t max_variables; // live variables per process
+    uint64_t seed;
+} DriverConfig;
+
+/** Builds one thread's command script: random allocate/set/print/dump/free against its own processes.
+    PIDs are only known once the processes exist, so the script refers to them by index and gets patched later **/
+void generateScript(const DriverConfig &config, uint64_t seed, std::vector<std::pair<uint32_t, std::string> > &script)
+{
+    static const char *types[] = {"char", "short", "int", "long", "float", "double"};
+    std::mt19937_64 rng(seed);
+    std::vector<std::vector<uint32_t> > live(config.processes);
+    uint32_t next_name = 0;
+    char line[512];
+
+    script.clear();
+    script.reserve(config.commands);
+    while (script.size() < config.commands)
+    {
+        uint32_t proc = rng() % config.processes;
+        std::vector<uint32_t> &vars = live[proc];
+        uint32_t roll = rng() % 100;
+
+        if (vars.empty() || (roll < 25 && vars.size() < config.max_variables))
+        {
+            uint32_t name = next_name++;
+            snprintf(line, sizeof(line), "allocate %%u v%u %s %u", name, types[rng() % 6], 1 + (uint32_t)(rng() % 2048));
+            vars.push_back(name);
+        }
+        else if (roll < 35)
+        {
+            size_t victim = rng() % vars.size();
+            snprintf(line, sizeof(line), "free %%u v%u", vars[victim]);
+            vars[victim] = vars.back();
+            vars.pop_back();
+        }
+        else if (roll < 75)
+        {
+            // Offset 0 always exists, whatever the variable's length turned out to be
+            int length = snprintf(line, sizeof(line), "set %%u v%u 0", vars[rng() % vars.size()]);
+            for (int i = 0; i < 16; i++)
+            {
+                length += snprintf(line + length, sizeof(line) - length, " %u", (uint32_t)(rng() % 100));
+            }
+        }
+        else if (roll < 95)
+        {
+            snprintf(line, sizeof(line), "print %%u:v%u", vars[rng() % vars.size()]);
+        }
+        else
+        {
+            snprintf(line, sizeof(line), "dump %%u:v%u 0 64", vars[rng() % vars.size()]);
+        }
+        script.push_back(std::make_pair(proc, std::string(line)));
+    }
+}
+
+/** One thread's run: create its processes, replay its script against them, then terminate them **/
+void runWorker(Simulator sim, const DriverConfig &config, const std::vector<std::pair<uint32_t, std::string> > &script)
+{
+    std::vector<uint32_t> pids(config.processes);
+    for (uint32_t i = 0; i < config.processes; i++)
+    {
+        pids[i] = createProcess(&sim, 4096, 1024);
+    }
+
+    // Substitute the PID, then hand the line to the same parser the interactive loop uses
+    char line[600];
+    for (size_t i = 0; i < script.size(); i++)
+    {
+        int length = snprintf(line, sizeof(line), script[i].second.c_str(), pids[script[i].first]);
+        executeCommand(&sim, line, length);
+    }
+
+    for (uint32_t i = 0; i < config.processes; i++)
+    {
+        terminateProcess(&sim, pids[i]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    DriverConfig config = {8, 200000, 16, 1};
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t mem_size = 256ULL << 20;
+    int page_size = 4096;
+    uint32_t tlb_entries = 0;
+    // Demand paging puts every access under one paging lock and lets threads evict each other's pages
+    bool demand_paging = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            max_threads = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--processes" && i + 1 < argc) {
+            config.processes = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--commands" && i + 1 < argc) {
+            config.commands = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--seed" && i + 1 < argc) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--page-size" && i + 1 < argc) {
+            page_size = atoi(argv[++i]);
+        } else if (option == "--memory" && i + 1 < argc) {
+            mem_size = strtoull(argv[++i], NULL, 10) << 20;
+        } else if (option == "--tlb" && i + 1 < argc) {
+            tlb_entries = strtoul(argv[++i], NULL, 10);
+        } else if (option == "--demand-paging") {
+            demand_paging = true;
+        } else {
+            fprintf(stderr, "usage: %s [--threads N] [--processes N] [--commands N] [--seed N] [--page-size N] [--memory MiB] [--tlb N] [--demand-paging]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (page_size <= 0 || mem_size < (uint64_t)page_size || mem_size / page_size > 0x7FFFFFFF)
+    {
+        fprintf(stderr, "Error: memory size must hold between 1 and 2^31-1 pages\n");
+        return 1;
+    }
+    if (demand_paging && 4 * mem_size / page_size > 0x7FFFFFFF)
+    {
+        fprintf(stderr, "Error: swap (4x memory) must hold at most 2^31-1 pages\n");
+        return 1;
+    }
+
+    // Scripts are built up front so generating them doesn't count towards the timings
+    std::vector<std::vector<std::pair<uint32_t, std::string> > > scripts(max_threads);
+    for (uint32_t t = 0; t < max_threads; t++)
+    {
+        generateScript(config, config.seed + t, scripts[t]);
+    }
+
+    // Commands print as they go; keep the console for the report and send the rest to /dev/null
+    fflush(stdout);
+    FILE *report = fdopen(dup(STDOUT_FILENO), "w");
+    std::cout.setstate(std::ios::badbit);
+    if (report == NULL || freopen("/dev/null", "w", stdout) == NULL)
+    {
+        fprintf(stderr, "Error: cannot suppress output\n");
+        return 1;
+    }
+
+    fprintf(report, "%u processes x %llu commands per thread, %d-byte pages, %llu MiB memory%s\n\n", config.processes,
+        (unsigned long long)config.commands, page_size, (unsigned long long)(mem_size >> 20),
+        demand_paging ? ", demand paging with 4x swap" : "");
+    fprintf(report, " Threads | Commands   | Time (ms) | Commands/sec | Speedup | Leaks\n");
+    fprintf(report, "---------+------------+-----------+--------------+---------+-------\n");
+    double base_rate = 0.0;
+    for (uint32_t threads = 1; ; threads = std::min(threads * 2, max_threads))
+    {
+        // A fresh machine per run, so every thread count starts from the same empty state
+        PhysicalMemory physical(mem_size, false);
+        uint64_t swap_size = demand_paging ? 4 * mem_size : 0;
+        Mmu mmu(mem_size + swap_size, page_size, FirstFit);
+        PageTable page_table(page_size, mem_size);
+        SwapFile *swap = NULL;
+        if (demand_paging)
+        {
+            swap = new SwapFile("concurrent_driver.swap", (uint32_t)(swap_size / page_size), page_size);
+            if (!swap->isOpen())
+            {
+                fprintf(stderr, "Error: cannot create swap file\n");
+                return 1;
+            }
+            page_table.enableDemandPaging(physical.getBase(), swap, createPageReplacer(ReplacementPolicy::Clock, page_table.getNumFrames()));
+        }
+        Tlb *tlb = NULL;
+        if (tlb_entries > 0)
+        {
+            TlbConfig tlb_config = {tlb_entries, 4, TlbPolicy::TlbLru, true};
+            tlb = new Tlb(tlb_config);
+            page_table.setTlb(tlb);
+        }
+
+        Simulator sim;
+        sim.mmu = &mmu;
+        sim.page_table = &page_table;
+        sim.tlb = tlb;
+        sim.memory = physical.getBase();
+        sim.physical = &physical;
+        sim.page_size = page_size;
+        sim.out = &std::cout;
+
+        std::vector<std::thread> workers;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            // Each thread gets its own copy of the simulator, and with it its own scratch buffers
+            workers.push_back(std::thread(runWorker, sim, std::cref(config), std::cref(scripts[t])));
+        }
+        for (size_t t = 0; t < workers.size(); t++)
+        {
+            workers[t].join();
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Every process was terminated, so anything still held is a bookkeeping bug
+        bool leaked = mmu.getUsedBytes() != 0 || page_table.getFreeFrames() != page_table.getNumFrames();
+        uint64_t commands = (uint64_t)threads * (config.commands + 2 * config.processes);
+        double rate = seconds > 0 ? commands / seconds : 0.0;
+        if (threads == 1) { base_rate = rate; }
+        fprintf(report, " %7u | %10llu | %9.1f | %12.0f | %6.2fx | %s\n", threads, (unsigned long long)commands,
+            seconds * 1000.0, rate, base_rate > 0 ? rate / base_rate : 0.0, leaked ? "yes" : "no");
+        delete tlb;
+        delete swap;
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+    fclose(report);
+    return 0;
+}
@@ -0,0 +1,280 @@
+/** Times the simulator's basic operations one at a time on a fresh machine, for every combination of page size,
+    process count and variables per process, and reports the cost of each in ns/op **/
+#include <iostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "commands.h"
+#include "mmu.h"
+#include "pagetable.h"
+#include "physicalmemory.h"
+
+enum Operation {OpCreate, OpAllocate, OpSet, OpPrint, OpTranslate, OpFree, OpTerminate, NUM_OPERATIONS};
+static const char *operation_names[NUM_OPERATIONS] = {"create", "allocate", "set", "print", "translate", "free", "terminate"};
+
+/** One point of the sweep **/
+typedef struct BenchConfig {
+    int page_size;
+    uint32_t processes;
+    uint32_t variables;     // per process
+} BenchConfig;
+
+/** Swallows command output while still letting the stream format it, so "print" pays for its formatting **/
+class DiscardBuffer : public std::streambuf {
+private:
+    char _buffer[4096];
+
+protected:
+    int overflow(int c)
+    {
+        setp(_buffer, _buffer + sizeof(_buffer));
+        return traits_type::not_eof(c);
+    }
+};
+
+static double elapsedNs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** Runs every operation once over the whole configuration and stores ns/op for each.
+    The operations build on each other: processes are created, filled with variables, written, read and translated,
+    then half the variables are freed and the processes terminated with the other half still live **/
+void runOnce(const BenchConfig &config, uint64_t memory_size, uint64_t translations, uint64_t seed, double *ns_per_op)
+{
+    std::mt19937_64 rng(seed);
+    PhysicalMemory physical(memory_size, false);
+    Mmu mmu(memory_size, config.page_size, BestFit);
+    PageTable page_table(config.page_size, memory_size);
+    DiscardBuffer discard;
+    std::ostream out(&discard);
+
+    Simulator sim;
+    sim.mmu = &mmu;
+    sim.page_table = &page_table;
+    sim.tlb = NULL;
+    sim.memory = physical.getBase();
+    sim.physical = &physical;
+    sim.page_size = config.page_size;
+    sim.out = &out;
+
+    // Everything the timed loops need is prepared first: names, sizes, command lines and translation targets
+    std::vector<std::string> names(config.variables);
+    std::vector<uint32_t> sizes(config.variables);
+    for (uint32_t v = 0; v < config.variables; v++)
+    {
+        names[v] = "v" + std::to_string(v);
+        sizes[v] = 1 + (uint32_t)(rng() % 256);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<uint32_t> pids(config.processes);
+    for (uint32_t p = 0; p < config.processes; p++)
+    {
+        pids[p] = createProcess(&sim, 4096, 1024);
+    }
+    ns_per_op[OpCreate] = elapsedNs(start) / config.processes;
+
+    uint64_t num_variables = (uint64_t)config.processes * config.variables;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < config.processes; p++)
+    {
+        for (uint32_t v = 0; v < config.variables; v++)
+        {
+            allocateVariable(&sim, pids[p], names[v], Int, sizes[v]);
+        }
+    }
+    ns_per_op[OpAllocate] = elapsedNs(start) / num_variables;
+
+    std::vector<std::string> set_lines;
+    std::vector<std::string> print_lines;
+    set_lines.reserve(num_variables);
+    print_lines.reserve(num_variables);
+    for (uint32_t p = 0; p < config.processes; p++)
+    {
+        for (uint32_t v = 0; v < config.variables; v++)
+        {
+            std::string pid = std::to_string(pids[p]);
+            std::string line = "set " + pid + " " + names[v] + " 0";
+            for (uint32_t i = 0; i < std::min<uint32_t>(sizes[v], 8); i++)
+            {
+                line += " " + std::to_string(rng() % 1000);
+            }
+            set_lines.push_back(line);
+            print_lines.push_back("print " + pid + ":" + names[v]);
+        }
+    }
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < set_lines.size(); i++)
+    {
+        executeCommand(&sim, set_lines[i].data(), set_lines[i].size());
+    }
+    ns_per_op[OpSet] = elapsedNs(start) / num_variables;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < print_lines.size(); i++)
+    {
+        executeCommand(&sim, print_lines[i].data(), print_lines[i].size());
+    }
+    ns_per_op[OpPrint] = elapsedNs(start) / num_variables;
+
+    // Random addresses inside live variables, so every translation hits a mapped page
+    std::vector<std::pair<uint32_t, uint32_t> > targets(translations);
+    for (uint64_t i = 0; i < translations; i++)
+    {
+        uint32_t p = rng() % config.processes;
+        Variable *var = mmu.getVariable(pids[p], names[rng() % config.variables]);
+        targets[i] = std::make_pair(pids[p], var->virtual_address + (uint32_t)(rng() % var->size));
+    }
+    uint64_t checksum = 0;
+    start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < translations; i++)
+    {
+        checksum += page_table.getPhysicalAddress(targets[i].first, targets[i].second);
+    }
+    ns_per_op[OpTranslate] = elapsedNs(start) / translations;
+    // Keeps the loop from being optimized away
+    if (checksum == 1) { fprintf(stderr, " "); }
+
+    // Every other variable, in a random order, so frees coalesce with neighbours some of the time
+    std::vector<std::pair<uint32_t, uint32_t> > victims;
+    for (uint32_t p = 0; p < config.processes; p++)
+    {
+        for (uint32_t v = 0; v < config.variables; v += 2)
+        {
+            victims.push_back(std::make_pair(pids[p], v));
+        }
+    }
+    std::shuffle(victims.begin(), victims.end(), rng);
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < victims.size(); i++)
+    {
+        freeVariable(&sim, victims[i].first, names[victims[i].second]);
+    }
+    ns_per_op[OpFree] = victims.empty() ? 0.0 : elapsedNs(start) / victims.size();
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t p = 0; p < config.processes; p++)
+    {
+        terminateProcess(&sim, pids[p]);
+    }
+    ns_per_op[OpTerminate] = elapsedNs(start) / config.processes;
+}
+
+/** Parses a comma-separated list of positive numbers **/
+bool parseList(const char *text, std::vector<uint32_t> &values)
+{
+    values.clear();
+    while (*text != '\0')
+    {
+        char *end;
+        unsigned long value = strtoul(text, &end, 10);
+        if (end == text || value == 0 || (*end != ',' && *end != '\0'))
+        {
+            return false;
+        }
+        values.push_back((uint32_t)value);
+        text = (*end == ',') ? end + 1 : end;
+    }
+    return !values.empty();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<uint32_t> page_sizes = {1024, 4096, 16384};
+    std::vector<uint32_t> process_counts = {1, 16, 256};
+    std::vector<uint32_t> variable_counts = {16, 256};
+    uint64_t memory_size = 1ULL << 30;
+    uint64_t translations = 1000000;
+    uint32_t repeats = 3;
+    uint64_t seed = 1;
+    bool csv = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        bool ok = true;
+        if (option == "--page-sizes" && i + 1 < argc) {
+            ok = parseList(argv[++i], page_sizes);
+        } else if (option == "--processes" && i + 1 < argc) {
+            ok = parseList(argv[++i], process_counts);
+        } else if (option == "--variables" && i + 1 < argc) {
+            ok = parseList(argv[++i], variable_counts);
+        } else if (option == "--memory" && i + 1 < argc) {
+            memory_size = strtoull(argv[++i], NULL, 10) << 20;
+        } else if (option == "--translations" && i + 1 < argc) {
+            translations = std::max(1ULL, strtoull(argv[++i], NULL, 10));
+        } else if (option == "--repeat" && i + 1 < argc) {
+            repeats = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--csv") {
+            csv = true;
+        } else {
+            ok = false;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "usage: %s [--page-sizes N,...] [--processes N,...] [--variables N,...] [--memory MiB] [--translations N] [--repeat N] [--seed N] [--csv]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Each process takes its text, globals and 64 KB stack plus up to 1 KB per variable
+    uint64_t largest = (uint64_t)*std::max_element(process_counts.begin(), process_counts.end()) *
+        (4096 + 1024 + 65536 + 1024ULL * *std::max_element(variable_counts.begin(), variable_counts.end()));
+    if (memory_size < largest || memory_size / *std::min_element(page_sizes.begin(), page_sizes.end()) > 0x7FFFFFFF)
+    {
+        fprintf(stderr, "Error: memory size must hold the largest configuration (%llu MiB) in at most 2^31-1 pages\n",
+            (unsigned long long)((largest >> 20) + 1));
+        return 1;
+    }
+
+    if (csv) {
+        printf("page_size,processes,variables");
+        for (int op = 0; op < NUM_OPERATIONS; op++) { printf(",%s_ns", operation_names[op]); }
+        printf("\n");
+    } else {
+        printf("ns/op, median of %u runs; %llu translations per run, %llu MiB memory\n\n", repeats,
+            (unsigned long long)translations, (unsigned long long)(memory_size >> 20));
+        printf(" Page size | Processes | Vars/proc |");
+        for (int op = 0; op < NUM_OPERATIONS; op++) { printf(" %9s |", operation_names[op]); }
+        printf("\n-----------+-----------+-----------+");
+        for (int op = 0; op < NUM_OPERATIONS; op++) { printf("-----------+"); }
+        printf("\n");
+    }
+
+    for (size_t s = 0; s < page_sizes.size(); s++)
+    {
+        for (size_t p = 0; p < process_counts.size(); p++)
+        {
+            for (size_t v = 0; v < variable_counts.size(); v++)
+            {
+                BenchConfig config = {(int)page_sizes[s], process_counts[p], variable_counts[v]};
+                std::vector<std::vector<double> > samples(NUM_OPERATIONS, std::vector<double>(repeats));
+                for (uint32_t r = 0; r < repeats; r++)
+                {
+                    double ns_per_op[NUM_OPERATIONS];
+                    runOnce(config, memory_size, translations, seed + r, ns_per_op);
+                    for (int op = 0; op < NUM_OPERATIONS; op++) { samples[op][r] = ns_per_op[op]; }
+                }
+
+                printf(csv ? "%d,%u,%u" : " %9d | %9u | %9u |", config.page_size, config.processes, config.variables);
+                for (int op = 0; op < NUM_OPERATIONS; op++)
+                {
+                    std::sort(samples[op].begin(), samples[op].end());
+                    printf(csv ? ",%.1f" : " %9.1f |", samples[op][repeats / 2]);
+                }
+                printf("\n");
+                fflush(stdout);
+            }
+        }
+    }
+    return 0;
+}
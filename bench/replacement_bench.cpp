@@ -0,0 +1,192 @@
+/** Replays one page access trace against every replacement policy for a sweep of frame counts **/
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include "pagetable.h"
+#include "physicalmemory.h"
+#include "swapfile.h"
+#include "replacement.h"
+
+/** One page touch in the trace **/
+typedef struct Access {
+    uint32_t page;
+    bool write;
+} Access;
+
+/** Result of replaying the trace once **/
+typedef struct RunResult {
+    PagingStats stats;
+    double seconds;
+} RunResult;
+
+/** Synthetic workload: runs of Zipf-distributed hot-set accesses, looping scans and uniform noise **/
+void generateTrace(uint32_t num_pages, uint64_t num_accesses, uint64_t seed, std::vector<Access> &trace)
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // Zipf(0.9) over a shuffled page order, so the hot pages are scattered through the address space
+    std::vector<double> cdf(num_pages);
+    double sum = 0.0;
+    for (uint32_t i = 0; i < num_pages; i++)
+    {
+        sum += 1.0 / pow(i + 1, 0.9);
+        cdf[i] = sum;
+    }
+    std::vector<uint32_t> rank(num_pages);
+    for (uint32_t i = 0; i < num_pages; i++) { rank[i] = i; }
+    std::shuffle(rank.begin(), rank.end(), rng);
+
+    trace.clear();
+    trace.reserve(num_accesses);
+    while (trace.size() < num_accesses)
+    {
+        uint64_t run = std::min<uint64_t>(10000, num_accesses - trace.size());
+        double pattern = unit(rng);
+        uint32_t scan_start = rng() % num_pages;
+        uint32_t scan_length = std::max<uint32_t>(1, num_pages / 4);
+        for (uint64_t i = 0; i < run; i++)
+        {
+            Access access;
+            if (pattern < 0.6) {
+                access.page = rank[std::lower_bound(cdf.begin(), cdf.end(), unit(rng) * sum) - cdf.begin()];
+            } else if (pattern < 0.85) {
+                access.page = (scan_start + i % scan_length) % num_pages;
+            } else {
+                access.page = rng() % num_pages;
+            }
+            access.write = unit(rng) < 0.3;
+            trace.push_back(access);
+        }
+    }
+}
+
+/** Reads "<page> [r|w]" lines; returns false if the file can't be read **/
+bool readTrace(const char *path, std::vector<Access> &trace, uint32_t *num_pages)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        return false;
+    }
+    std::string line;
+    *num_pages = 0;
+    trace.clear();
+    while (std::getline(file, line))
+    {
+        char mode = 'r';
+        unsigned long page;
+        if (line.empty() || line[0] == '#' || sscanf(line.c_str(), "%lu %c", &page, &mode) < 1)
+        {
+            continue;
+        }
+        Access access = {(uint32_t)page, mode == 'w'};
+        trace.push_back(access);
+        *num_pages = std::max(*num_pages, access.page + 1);
+    }
+    return true;
+}
+
+/** Replays the trace through a demand-paged page table with num_frames frames **/
+RunResult replay(const std::vector<Access> &trace, uint32_t num_pages, uint32_t num_frames, int page_size, PageReplacer *replacer)
+{
+    PhysicalMemory memory((uint64_t)num_frames * page_size, false);
+    SwapFile swap("replacement_bench.swap", num_pages, page_size);
+    PageTable page_table(page_size, (uint64_t)num_frames * page_size);
+    page_table.enableDemandPaging(memory.getBase(), &swap, replacer);
+    for (uint32_t page = 0; page < num_pages; page++)
+    {
+        page_table.reserveEntry(1, page);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+        uint64_t address = page_table.getPhysicalAddress(1, trace[i].page * page_size, trace[i].write);
+        if (trace[i].write)
+        {
+            memory.getBase()[address]++;
+        }
+    }
+    RunResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.stats = page_table.getPagingStats();
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t num_pages = 4096;
+    uint64_t num_accesses = 1000000;
+    uint64_t seed = 1;
+    int page_size = 4096;
+    const char *trace_path = NULL;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--pages" && i + 1 < argc) {
+            num_pages = strtoul(argv[++i], NULL, 10);
+        } else if (option == "--accesses" && i + 1 < argc) {
+            num_accesses = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--seed" && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--page-size" && i + 1 < argc) {
+            page_size = atoi(argv[++i]);
+        } else if (option == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--pages N] [--accesses N] [--seed N] [--page-size N] [--trace <file>]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::vector<Access> trace;
+    if (trace_path != NULL) {
+        if (!readTrace(trace_path, trace, &num_pages)) {
+            fprintf(stderr, "Error: cannot read trace '%s'\n", trace_path);
+            return 1;
+        }
+    } else if (num_pages > 0) {
+        generateTrace(num_pages, num_accesses, seed, trace);
+    }
+    if (trace.empty() || num_pages == 0 || page_size <= 0)
+    {
+        fprintf(stderr, "Error: nothing to replay\n");
+        return 1;
+    }
+
+    // OPT needs the trace as page table keys, in access order
+    std::vector<uint64_t> keys(trace.size());
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+        keys[i] = pageTableKey(1, trace[i].page);
+    }
+
+    printf("%zu accesses over %u pages of %d bytes\n\n", trace.size(), num_pages, page_size);
+    printf(" Frames | Policy | Faults     | Fault Rate | Write-backs | Time (ms)\n");
+    printf("--------+--------+------------+------------+-------------+-----------\n");
+    const ReplacementPolicy policies[] = {Clock, Fifo, Lru, Lfu, Arc};
+    for (uint32_t divisor = 64; divisor >= 2; divisor /= 2)
+    {
+        uint32_t num_frames = std::max<uint32_t>(1, num_pages / divisor);
+        for (size_t p = 0; p <= sizeof(policies) / sizeof(policies[0]); p++)
+        {
+            // The last run of each sweep step is the offline optimum, as a lower bound for the others
+            PageReplacer *replacer = (p < sizeof(policies) / sizeof(policies[0])) ?
+                createPageReplacer(policies[p], num_frames) : new OptReplacer(num_frames, keys);
+            const char *name = replacer->getName();
+            RunResult result = replay(trace, num_pages, num_frames, page_size, replacer);
+            printf(" %6u | %-6s | %10llu | %9.2f%% | %11llu | %9.1f\n", num_frames, name,
+                (unsigned long long)result.stats.faults, 100.0 * result.stats.faults / result.stats.accesses,
+                (unsigned long long)result.stats.write_backs, result.seconds * 1000.0);
+        }
+    }
+    return 0;
+}
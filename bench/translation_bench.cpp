@@ -0,0 +1,194 @@
+/** Measures how address translation throughput scales with the number of reading threads, optionally while another
+    thread keeps mapping and unmapping pages of its own processes **/
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include "pagetable.h"
+#include "tlb.h"
+
+/** One reader's result **/
+typedef struct ReaderResult {
+    uint64_t translations;
+    uint64_t mismatches;    // translations that didn't land on the frame the page was mapped to
+} ReaderResult;
+
+/** Translates random addresses of the shared processes until told to stop, checking each against the expected frame **/
+void runReader(PageTable *page_table, const std::vector<uint32_t> *pids, const std::vector<int> *frames, uint32_t pages_per_process,
+    uint64_t seed, const std::atomic<bool> *stop, ReaderResult *result)
+{
+    std::mt19937_64 rng(seed);
+    int page_size = page_table->getPageSize();
+    uint64_t translations = 0;
+    uint64_t mismatches = 0;
+
+    // Addresses are drawn in blocks up front so the random number generator stays out of the timed loop
+    std::vector<uint32_t> picks(4096);
+    while (!stop->load(std::memory_order_relaxed))
+    {
+        for (size_t i = 0; i < picks.size(); i++)
+        {
+            picks[i] = (uint32_t)(rng() % ((uint64_t)pids->size() * pages_per_process));
+        }
+        for (size_t i = 0; i < picks.size(); i++)
+        {
+            uint32_t proc = picks[i] / pages_per_process;
+            uint32_t page = picks[i] % pages_per_process;
+            uint64_t address = page_table->getPhysicalAddress((*pids)[proc], page * page_size + 7);
+            if (address != (uint64_t)(*frames)[picks[i]] * page_size + 7)
+            {
+                mismatches++;
+            }
+        }
+        translations += picks.size();
+    }
+    result->translations = translations;
+    result->mismatches = mismatches;
+}
+
+/** Keeps mapping and unmapping pages, and tearing whole processes down, on PIDs the readers never touch **/
+void runWriter(PageTable *page_table, uint32_t *next_pid, uint32_t pages_per_process, const std::atomic<bool> *stop, uint64_t *operations)
+{
+    uint32_t pid = *next_pid;
+    uint64_t count = 0;
+    while (!stop->load(std::memory_order_relaxed))
+    {
+        for (uint32_t page = 0; page < pages_per_process; page++)
+        {
+            page_table->addEntry(pid, page);
+        }
+        for (uint32_t page = 0; page < pages_per_process; page += 2)
+        {
+            page_table->freeSinglePage(pid, page);
+        }
+        page_table->freeAllPagesOfProcess(pid);
+        count += pages_per_process + pages_per_process / 2 + 1;
+        pid++;
+    }
+    *next_pid = pid;
+    *operations = count;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t num_processes = 64;
+    uint32_t pages_per_process = 256;
+    int page_size = 4096;
+    uint32_t tlb_entries = 0;
+    double seconds = 0.5;
+    bool writer = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--threads" && i + 1 < argc) {
+            max_threads = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--processes" && i + 1 < argc) {
+            num_processes = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--pages" && i + 1 < argc) {
+            pages_per_process = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--page-size" && i + 1 < argc) {
+            page_size = atoi(argv[++i]);
+        } else if (option == "--tlb" && i + 1 < argc) {
+            tlb_entries = strtoul(argv[++i], NULL, 10);
+        } else if (option == "--seconds" && i + 1 < argc) {
+            seconds = atof(argv[++i]);
+        } else if (option == "--writer") {
+            writer = true;
+        } else {
+            fprintf(stderr, "usage: %s [--threads N] [--processes N] [--pages N] [--page-size N] [--tlb N] [--seconds S] [--writer]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (page_size <= 0)
+    {
+        fprintf(stderr, "Error: page size must be positive\n");
+        return 1;
+    }
+
+    // Room for the readers' pages plus the writer's churn
+    uint64_t num_frames = 2ULL * num_processes * pages_per_process + pages_per_process;
+    PageTable page_table(page_size, num_frames * page_size);
+    Tlb *tlb = NULL;
+    if (tlb_entries > 0)
+    {
+        TlbConfig tlb_config = {tlb_entries, 4, TlbPolicy::TlbLru, true};
+        tlb = new Tlb(tlb_config);
+        page_table.setTlb(tlb);
+    }
+
+    // The readers' processes are mapped once and never change, so every translation has one right answer
+    std::vector<uint32_t> pids(num_processes);
+    std::vector<int> frames((size_t)num_processes * pages_per_process);
+    for (uint32_t p = 0; p < num_processes; p++)
+    {
+        pids[p] = 1024 + p;
+        for (uint32_t page = 0; page < pages_per_process; page++)
+        {
+            page_table.addEntry(pids[p], page);
+            frames[(size_t)p * pages_per_process + page] = (int)(page_table.getPhysicalAddress(pids[p], page * page_size) / page_size);
+        }
+    }
+
+    printf("%u processes x %u pages of %d bytes, %s, %.1f s per run%s\n\n", num_processes, pages_per_process, page_size,
+        tlb != NULL ? "shared TLB" : "no TLB", seconds, writer ? ", with a concurrent writer" : "");
+    printf(" Readers | Translations | Mtrans/sec | Speedup | Writer ops | Mismatches\n");
+    printf("---------+--------------+------------+---------+------------+------------\n");
+    double base_rate = 0.0;
+    // The writer works on fresh PIDs past the readers', carrying on from run to run
+    uint32_t writer_pid = 1024 + num_processes;
+    for (uint32_t threads = 1; ; threads = std::min(threads * 2, max_threads))
+    {
+        std::atomic<bool> stop(false);
+        std::vector<ReaderResult> results(threads);
+        std::vector<std::thread> readers;
+        uint64_t writer_ops = 0;
+        std::thread writer_thread;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            readers.push_back(std::thread(runReader, &page_table, &pids, &frames, pages_per_process, (uint64_t)t + 1, &stop, &results[t]));
+        }
+        if (writer)
+        {
+            writer_thread = std::thread(runWriter, &page_table, &writer_pid, pages_per_process, &stop, &writer_ops);
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+        stop.store(true);
+        for (size_t t = 0; t < readers.size(); t++)
+        {
+            readers[t].join();
+        }
+        if (writer)
+        {
+            writer_thread.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t translations = 0;
+        uint64_t mismatches = 0;
+        for (size_t t = 0; t < results.size(); t++)
+        {
+            translations += results[t].translations;
+            mismatches += results[t].mismatches;
+        }
+        double rate = translations / elapsed / 1e6;
+        if (threads == 1) { base_rate = rate; }
+        printf(" %7u | %12llu | %10.2f | %6.2fx | %10llu | %10llu\n", threads, (unsigned long long)translations, rate,
+            base_rate > 0 ? rate / base_rate : 0.0, (unsigned long long)writer_ops, (unsigned long long)mismatches);
+
+        if (threads == max_threads)
+        {
+            break;
+        }
+    }
+    delete tlb;
+    return 0;
+}
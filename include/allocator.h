@@ -0,0 +1,147 @@
+#ifndef __ALLOCATOR_H_
+#define __ALLOCATOR_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdint>
+
+enum AllocationPolicy : uint8_t {FirstFit, BestFit, NextFit, Segregated, Buddy};
+
+/** A free range of a heap, as saved in a checkpoint **/
+typedef struct HeapBlock {
+    uint32_t address;
+    uint32_t size;
+} HeapBlock;
+
+/** Hands out ranges of one process's virtual address space **/
+class HeapAllocator {
+protected:
+    uint32_t _capacity;
+    uint32_t _free_bytes;
+
+public:
+    HeapAllocator(uint32_t capacity);
+    virtual ~HeapAllocator();
+
+    // Reserves space for size bytes and returns its start address, or returns false if nothing fits
+    virtual bool allocate(uint32_t size, uint32_t *address) = 0;
+    // Gives back a range previously returned by allocate() for the same size
+    virtual void release(uint32_t address, uint32_t size) = 0;
+    // Bytes allocate() actually takes for a request of size bytes
+    virtual uint32_t reservedSize(uint32_t size);
+    virtual uint32_t getLargestFreeBlock() = 0;
+    virtual size_t getNumFreeBlocks() = 0;
+    // Checkpoints: the free blocks in address order, and where the next search starts (0 for allocators without a cursor)
+    virtual void getFreeBlocks(std::vector<HeapBlock> &blocks) = 0;
+    virtual bool restoreFreeBlocks(const HeapBlock *blocks, size_t count) = 0;
+    virtual uint32_t getCursor();
+    virtual void setCursor(uint32_t cursor);
+
+    uint32_t getCapacity();
+    uint32_t getFreeBytes();
+    double getFragmentation();
+    bool checkBlocks(const HeapBlock *blocks, size_t count);
+};
+
+/** Free blocks kept in an address-ordered map and coalesced on release; subclasses decide which block to carve from **/
+class FreeListAllocator : public HeapAllocator {
+protected:
+    std::map<uint32_t, uint32_t> _blocks;
+
+    void take(std::map<uint32_t, uint32_t>::iterator block, uint32_t size, uint32_t *address);
+    virtual void onInsert(uint32_t address, uint32_t size);
+    virtual void onErase(uint32_t address, uint32_t size);
+    void insertBlock(uint32_t address, uint32_t size);
+    std::map<uint32_t, uint32_t>::iterator eraseBlock(std::map<uint32_t, uint32_t>::iterator block);
+
+public:
+    FreeListAllocator(uint32_t capacity);
+
+    void release(uint32_t address, uint32_t size);
+    uint32_t getLargestFreeBlock();
+    size_t getNumFreeBlocks();
+    void getFreeBlocks(std::vector<HeapBlock> &blocks);
+    bool restoreFreeBlocks(const HeapBlock *blocks, size_t count);
+};
+
+/** Lowest-addressed free block that fits **/
+class FirstFitAllocator : public FreeListAllocator {
+public:
+    FirstFitAllocator(uint32_t capacity);
+    bool allocate(uint32_t size, uint32_t *address);
+};
+
+/** First block that fits, searching on from where the last allocation ended and wrapping around **/
+class NextFitAllocator : public FreeListAllocator {
+private:
+    uint32_t _rover;
+
+public:
+    NextFitAllocator(uint32_t capacity);
+    bool allocate(uint32_t size, uint32_t *address);
+    uint32_t getCursor();
+    void setCursor(uint32_t cursor);
+};
+
+/** Smallest free block that fits, lowest address first, found through a (size, address) index **/
+class BestFitAllocator : public FreeListAllocator {
+private:
+    std::set<std::pair<uint32_t, uint32_t> > _by_size;
+
+protected:
+    void onInsert(uint32_t address, uint32_t size);
+    void onErase(uint32_t address, uint32_t size);
+
+public:
+    BestFitAllocator(uint32_t capacity);
+    bool allocate(uint32_t size, uint32_t *address);
+    uint32_t getLargestFreeBlock();
+};
+
+/** Free blocks binned into power-of-two size classes, each class kept in address order **/
+class SegregatedAllocator : public FreeListAllocator {
+private:
+    static const int NUM_CLASSES = 32;
+    std::set<uint32_t> _classes[NUM_CLASSES];
+
+    static int sizeClass(uint32_t size);
+
+protected:
+    void onInsert(uint32_t address, uint32_t size);
+    void onErase(uint32_t address, uint32_t size);
+
+public:
+    SegregatedAllocator(uint32_t capacity);
+    bool allocate(uint32_t size, uint32_t *address);
+    uint32_t getLargestFreeBlock();
+};
+
+/** Binary buddy system: requests are rounded up to a power of two and freed blocks merge with their buddy **/
+class BuddyAllocator : public HeapAllocator {
+private:
+    static const int MIN_ORDER = 4;
+    int _max_order;
+    std::vector<std::set<uint32_t> > _free_lists;
+    size_t _num_free_blocks;
+
+    int order(uint32_t size);
+
+public:
+    BuddyAllocator(uint32_t capacity);
+
+    bool allocate(uint32_t size, uint32_t *address);
+    void release(uint32_t address, uint32_t size);
+    uint32_t reservedSize(uint32_t size);
+    uint32_t getLargestFreeBlock();
+    size_t getNumFreeBlocks();
+    void getFreeBlocks(std::vector<HeapBlock> &blocks);
+    bool restoreFreeBlocks(const HeapBlock *blocks, size_t count);
+};
+
+HeapAllocator* createHeapAllocator(AllocationPolicy policy, uint32_t capacity);
+bool parseAllocationPolicy(std::string name, AllocationPolicy *policy);
+const char* allocationPolicyName(AllocationPolicy policy);
+
+#endif // __ALLOCATOR_H_
@@ -0,0 +1,63 @@
+#ifndef __CHECKPOINT_H_
+#define __CHECKPOINT_H_
+
+#include <string>
+#include <cstdint>
+#include "commands.h"
+
+static const uint32_t CHECKPOINT_VERSION = 1;
+// The memory image starts on a multiple of this, so it can be mapped straight from the file on any common host page size
+static const uint64_t CHECKPOINT_IMAGE_ALIGN = 65536;
+
+/** Start of a checkpoint file. Every section after it is an array of fixed-size records at an 8-byte aligned offset,
+    written in the host's byte order, so a loader maps the file and uses the records where they lie **/
+typedef struct CheckpointHeader {
+    char magic[8];              // "MEMSIMCP"
+    uint32_t version;
+    uint32_t byte_order;        // 0x01020304 as stored by the host that saved it
+    uint32_t header_size;
+    // Only a machine configured the same way can load the checkpoint
+    uint32_t page_size;
+    uint64_t memory_size;
+    uint32_t policy;            // AllocationPolicy
+    // The process table's PID range; slots without a saved process were terminated
+    uint32_t first_pid;
+    uint32_t next_pid;
+    uint32_t reserved;
+    AllocatorStats alloc_stats;
+    // Sections: where each array starts and how many records it holds
+    uint64_t processes_offset;  // CheckpointProcess, by increasing PID
+    uint64_t num_processes;
+    uint64_t variables_offset;  // CheckpointVariable, each process's in address order
+    uint64_t num_variables;
+    uint64_t blocks_offset;     // HeapBlock, each process's free blocks in address order
+    uint64_t num_blocks;
+    uint64_t mappings_offset;   // PageMapping, by PID and then page number
+    uint64_t num_mappings;
+    uint64_t names_offset;      // variable names, back to back without terminators
+    uint64_t names_size;
+    uint64_t memory_offset;     // physical memory, memory_size bytes, holes where the memory was all zeros
+} CheckpointHeader;
+
+/** One process; its variables and free blocks are the next runs of those sections **/
+typedef struct CheckpointProcess {
+    uint32_t pid;
+    uint32_t used_bytes;
+    uint32_t reserved_bytes;
+    uint32_t heap_cursor;
+    uint32_t num_variables;
+    uint32_t num_blocks;
+} CheckpointProcess;
+
+typedef struct CheckpointVariable {
+    uint64_t name_offset;
+    uint32_t name_length;
+    uint32_t type;              // DataType
+    uint32_t virtual_address;
+    uint32_t size;
+} CheckpointVariable;
+
+bool saveCheckpoint(Simulator *sim, const std::string &path, const char **error);
+bool loadCheckpoint(Simulator *sim, const std::string &path, const char **error);
+
+#endif // __CHECKPOINT_H_
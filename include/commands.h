@@ -0,0 +1,57 @@
+#ifndef __COMMANDS_H_
+#define __COMMANDS_H_
+
+#include <string>
+#include <ostream>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "mmu.h"
+#include "pagetable.h"
+#include "tlb.h"
+#include "physicalmemory.h"
+
+/** A view into the command line buffer; tokens are never copied out of the line they came from **/
+typedef struct Token {
+    const char *data;
+    size_t length;
+} Token;
+
+/** Everything a command needs to run against one simulated machine. Threads sharing a machine each need their own copy, for the scratch space **/
+typedef struct Simulator {
+    Mmu *mmu;
+    PageTable *page_table;
+    Tlb *tlb;
+    void *memory;
+    PhysicalMemory *physical;
+    int page_size;
+    // Where command output goes: std::cout, or a buffer when commands run out of order and are printed later.
+    // The whole-machine tables (print mmu, page, tlb, ...) are printed by their owners straight to stdout
+    std::ostream *out;
+    // Scratch space reused from command to command so parsing doesn't allocate once it has warmed up
+    std::vector<Token> tokens;
+    std::string name;
+    // Values parsed by "set" before they are copied into simulated memory, and values read back by "print" and "dump"
+    std::vector<uint8_t> staging;
+    // Physical extents of the range being read by "print" and "dump"
+    std::vector<PhysicalExtent> extents;
+} Simulator;
+
+bool tokenEquals(Token token, const char *text);
+size_t tokenize(const char *line, size_t length, char delimiter, std::vector<Token> &tokens);
+bool parseUInt32(Token token, uint32_t *value);
+bool parseInt64(Token token, int64_t *value);
+bool parseDouble(Token token, double *value);
+bool parseDataType(Token token, DataType *type);
+
+void executeCommand(Simulator *sim, const char *line, size_t length);
+
+uint32_t createProcess(Simulator *sim, uint32_t text_size, uint32_t data_size);
+void allocateVariable(Simulator *sim, uint32_t pid, const std::string &var_name, DataType type, uint32_t num_elements);
+bool setVariable(Simulator *sim, uint32_t pid, Variable *var, uint32_t offset, const void *values, uint32_t length);
+void freeVariable(Simulator *sim, uint32_t pid, const std::string &var_name);
+void terminateProcess(Simulator *sim, uint32_t pid);
+void printVariable(Simulator *sim, uint32_t pid, Variable *var);
+int element_size(DataType type);
+
+#endif // __COMMANDS_H_
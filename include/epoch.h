@@ -0,0 +1,62 @@
+#ifndef __EPOCH_H_
+#define __EPOCH_H_
+
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/** Epoch-based reclamation: readers walk shared structures without taking locks, and writers hand whatever they
+    unlink to retire() instead of freeing it, so it is only freed once no reader can still be looking at it **/
+class EpochDomain {
+public:
+    static const int MAX_READERS = 256;
+
+private:
+    // One slot per reading thread, each on its own cache line; 0 while the thread is outside a read
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> claimed;
+    };
+
+    typedef struct Retired {
+        uint64_t epoch;
+        void (*destroy)(void *object);
+        void *object;
+    } Retired;
+
+    ReaderSlot _slots[MAX_READERS];
+    std::atomic<uint64_t> _epoch;
+    std::mutex _retired_lock;
+    std::vector<Retired> _retired;
+
+    void collectLocked();
+
+public:
+    EpochDomain();
+    ~EpochDomain();
+
+    int claimSlot();
+    void releaseSlot(int slot);
+    void enter(int slot);
+    void leave(int slot);
+    void retire(void *object, void (*destroy)(void *object));
+    void collect();
+
+    static EpochDomain& global();
+};
+
+/** Marks the calling thread as reading for as long as the guard lives. Threads get a slot on first use and keep it
+    until they exit; if all slots are taken, active() is false and the caller has to fall back to taking locks **/
+class EpochGuard {
+private:
+    int _slot;
+
+public:
+    EpochGuard();
+    ~EpochGuard();
+
+    bool active() { return _slot >= 0; }
+};
+
+#endif // __EPOCH_H_
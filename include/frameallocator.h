@@ -0,0 +1,32 @@
+#ifndef __FRAMEALLOCATOR_H_
+#define __FRAMEALLOCATOR_H_
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+
+/** Tracks which physical frames are in use with one bit per frame; safe to call from several threads at once **/
+class FrameAllocator {
+private:
+    uint32_t _num_frames;
+    uint32_t _num_words;
+    std::atomic<uint32_t> _free_frames;
+    // Index of the lowest bitmap word that may still contain a free frame (low 32 bits), and a count of releases
+    // (high 32 bits). Every release bumps the count, so an allocation that raced with one can't raise the index
+    // past the word it freed
+    std::atomic<uint64_t> _search;
+    std::unique_ptr<std::atomic<uint64_t>[]> _used;
+
+public:
+    FrameAllocator(uint32_t num_frames);
+    ~FrameAllocator();
+
+    int allocate();
+    void release(int frame);
+    bool claim(int frame);
+    bool isAllocated(int frame);
+    uint32_t getNumFrames();
+    uint32_t getFreeFrames();
+};
+
+#endif // __FRAMEALLOCATOR_H_
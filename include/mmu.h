@@ -4,45 +4,135 @@
 #include <iostream>
 #include <string>
 #include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include "nametable.h"
+#include "pool.h"
+#include "allocator.h"
 
 enum DataType : uint8_t {FreeSpace, Char, Short, Int, Float, Long, Double};
 
 typedef struct Variable {
-    std::string name;
+    // Interned name id (see Mmu::getVariableName)
+    uint32_t name;
     DataType type;
     uint32_t virtual_address;
     uint32_t size;
 } Variable;
 
+typedef struct PageUsage {
+    uint32_t live_bytes;
+    uint32_t live_variables;
+} PageUsage;
+
 typedef struct Process {
     uint32_t pid;
-    std::vector<Variable*> variables;
+    // Guards everything below; held by each Mmu call that reads or changes this process
+    std::mutex lock;
+    // Bytes held by live variables of this process, and the bytes the allocator set aside for them
+    uint32_t used_bytes;
+    uint32_t reserved_bytes;
+    // Live variables ordered by virtual address
+    std::map<uint32_t, Variable*> variables;
+    // Interned name id -> variable
+    std::unordered_map<uint32_t, Variable*> names;
+    // Hands out free ranges of the process's virtual address space
+    HeapAllocator *heap;
+    // Page number -> bytes and variables living on that page, for every page with at least one variable
+    std::unordered_map<uint32_t, PageUsage> pages;
+    // Every Variable record of this process lives here and is released in bulk on terminate
+    ObjectPool<Variable> variable_pool;
 } Process;
 
+typedef struct AllocatorStats {
+    uint64_t allocations;
+    uint64_t failures;
+    uint64_t releases;
+    uint64_t allocate_ns;
+    uint64_t max_allocate_ns;
+    uint64_t release_ns;
+} AllocatorStats;
+
+/** Processes, their variables and their heaps.
+    Safe to use from several threads: the process table, the name table and the allocator statistics each have a
+    lock, and every process has its own, so calls for different processes run in parallel. A process must not be
+    terminated while another thread is still using it or its variables **/
 class Mmu {
 private:
+    uint32_t _first_pid;
     uint32_t _next_pid;
-    uint32_t _max_size;
-    std::vector<Process*> _processes;
+    // Physical memory shared by all processes, and the virtual address space each process gets (at most 4 GB)
+    uint64_t _max_size;
+    uint32_t _process_size;
+    uint32_t _page_size;
+    uint32_t _num_processes;
+    // Slab caches are declared before the pools drawing from them so they outlive the pools
+    SlabCache _process_slabs;
+    SlabCache _variable_slabs;
+    ObjectPool<Process> _process_pool;
+    // Bytes held by live variables across all processes, and the bytes the allocators set aside for them
+    std::atomic<uint64_t> _used_bytes;
+    std::atomic<uint64_t> _reserved_bytes;
+    AllocationPolicy _policy;
+    std::mutex _stats_lock;
+    AllocatorStats _alloc_stats;
+    // Guards _first_pid, _next_pid, _num_processes, _processes and _process_pool
+    std::mutex _table_lock;
+    // Dense PID-indexed table: slot (pid - _first_pid) holds the process, or NULL once it's terminated;
+    // terminated slots at the front are dropped and _first_pid moves past them
+    std::deque<Process*> _processes;
+    // Taken after a process lock when both are needed
+    std::mutex _names_lock;
+    NameTable _names;
+
+    Process* findProcessLocked(uint32_t pid);
+    void insertVariable(Process *proc, const std::string &var_name, DataType type, uint32_t size, uint32_t address);
+    bool reserveSpace(uint32_t size);
 
 public:
-    Mmu(int memory_size);
+    Mmu(uint64_t memory_size, int page_size, AllocationPolicy policy = AllocationPolicy::BestFit);
     ~Mmu();
 
     uint32_t createProcess();
-    void addVariableToProcess(uint32_t pid, std::string var_name, DataType type, uint32_t size, uint32_t address);
+    uint32_t getNextPid();
+    Process* getProcess(uint32_t pid);
+    void addVariableToProcess(uint32_t pid, const std::string &var_name, DataType type, uint32_t size, uint32_t address);
+    void addVariableToProcess(Process *proc, const std::string &var_name, DataType type, uint32_t size, uint32_t address);
+    Variable* allocateVariable(Process *proc, const std::string &var_name, DataType type, uint32_t size);
     void print();
     
-    bool checkTotalSpace(uint32_t pid);
+    bool checkTotalSpace(uint32_t newVariableSize);
+    uint64_t getUsedBytes();
+    uint64_t getFreeBytes();
+    uint32_t getProcessUsedBytes(uint32_t pid);
+    uint32_t getProcessFreeBytes(uint32_t pid);
+    void printMemoryUsage();
     std::vector<Variable*> getVariables(uint32_t pid);
-    int getFreeSpaceLeftOnPage(uint32_t pid, int page_number, int page_size, uint32_t address);
+    int getFreeSpaceLeftOnPage(uint32_t pid, int page_number);
     bool removeProcess(uint32_t pid);
-    Variable* getVariable(uint32_t pid, std::string var_name);
-    int getVariableWithaddress(uint32_t pid, uint32_t address);
+    Variable* getVariable(uint32_t pid, const std::string &var_name);
+    Variable* getVariable(Process *proc, const std::string &var_name);
+    const std::string& getVariableName(Variable *var);
+    Variable* getVariableWithaddress(uint32_t pid, uint32_t address);
+    Variable* getVariableWithaddress(Process *proc, uint32_t address);
     bool findProcess(uint32_t pid);
-    bool findVariable(uint32_t pid, std::string var_name);
+    bool findVariable(uint32_t pid, const std::string &var_name);
     void printProcesses();
-    void freeVariable(uint32_t pid, Variable* curVar);
+    void freeVariable(uint32_t pid, Variable* curVar, std::vector<int> *released_pages);
+    void freeVariable(Process *proc, Variable* curVar, std::vector<int> *released_pages);
+    AllocationPolicy getAllocationPolicy();
+    void printAllocatorStats();
+
+    // Checkpoints (see checkpoint.h)
+    std::vector<uint32_t> getPids();
+    uint32_t getFirstPid();
+    uint32_t getProcessSize();
+    AllocatorStats getAllocatorStats();
+    void restoreProcessTable(uint32_t first_pid, uint32_t next_pid, const AllocatorStats &stats);
+    Process* restoreProcess(uint32_t pid, uint32_t reserved_bytes);
 };
 
 #endif // __MMU_H_
@@ -0,0 +1,37 @@
+#ifndef __NAMETABLE_H_
+#define __NAMETABLE_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+/** One interned name and the number of live variables using it **/
+typedef struct NameEntry {
+    const std::string *name;
+    uint32_t references;
+} NameEntry;
+
+/** Interns variable names so each distinct name is stored once and compared as an integer id.
+    Names are reference counted: every intern() is matched by a release() when the variable goes away, and a name
+    nobody uses any more is dropped and its id reused, so the table only holds the names of live variables **/
+class NameTable {
+private:
+    std::unordered_map<std::string, uint32_t> _ids;
+    std::vector<NameEntry> _names;
+    // Ids of dropped names, handed out again before the table grows
+    std::vector<uint32_t> _free_ids;
+
+public:
+    static const uint32_t NOT_FOUND = 0xFFFFFFFF;
+
+    NameTable();
+    ~NameTable();
+
+    uint32_t intern(const std::string &name);
+    void release(uint32_t id);
+    uint32_t find(const std::string &name);
+    const std::string& getName(uint32_t id);
+};
+
+#endif // __NAMETABLE_H_
@@ -4,43 +4,138 @@
 #include <iostream>
 #include <string>
 #include <vector>
-#include <map>
+#include <unordered_map>
 #include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "frameallocator.h"
+#include "tlb.h"
+#include "swapfile.h"
+#include "replacement.h"
+#include "epoch.h"
 
-struct PageTableKeyComparator
+/** Packs a (pid, page number) pair into a single 64-bit page table key **/
+inline uint64_t pageTableKey(uint32_t pid, uint32_t page_number)
 {
-    inline bool operator() (const std::string& str1, const std::string& str2)
-    {
-        size_t sep1 = str1.find("|");
-        uint32_t pid1 = std::stoi(str1.substr(0, sep1));
-        int page1 = std::stoi(str1.substr(sep1 + 1));
-        size_t sep2 = str2.find("|");
-        uint32_t pid2 = std::stoi(str2.substr(0, sep2));
-        int page2 = std::stoi(str2.substr(sep2 + 1));
-
-        return (pid1 < pid2 || (pid1 == pid2 && page1 < page2));
-    }
-};
+    return ((uint64_t)pid << 32) | page_number;
+}
+
+inline uint32_t pageTableKeyPid(uint64_t key) { return (uint32_t)(key >> 32); }
+inline uint32_t pageTableKeyPage(uint64_t key) { return (uint32_t)key; }
+
+/** A run of physically contiguous bytes backing part of a virtual range **/
+typedef struct PhysicalExtent {
+    int frame;          // first frame of the run
+    uint32_t offset;    // byte offset into that frame
+    uint32_t length;    // bytes in the run; may cross into following frames when they are adjacent
+} PhysicalExtent;
+
+enum PageFlags : uint8_t {PagePresent = 1, PageDirty = 2, PageReferenced = 4};
+
+/** One page's mapping: the frame it occupies while present, and its copy in swap once it has been evicted **/
+typedef struct PageTableEntry {
+    int frame;          // -1 while the page is not resident
+    int swap_slot;      // -1 until the page is first written back
+    uint8_t flags;      // PageFlags
+} PageTableEntry;
 
+/** Demand paging fault and eviction counts **/
+typedef struct PagingStats {
+    uint64_t accesses;
+    uint64_t faults;        // accesses to a page that wasn't resident
+    uint64_t swap_ins;      // faults that had to read the page back from swap
+    uint64_t evictions;
+    uint64_t write_backs;   // evictions of dirty pages that had to be written to swap
+} PagingStats;
+
+/** One mapped page, as saved in a checkpoint **/
+typedef struct PageMapping {
+    uint32_t pid;
+    uint32_t page;
+    int32_t frame;
+} PageMapping;
+
+/** Lock-free view of one process's mappings: the frame behind each page number, -1 where nothing is mapped.
+    Replaced by a bigger copy when the process maps past the end, and only freed through the epoch domain **/
+typedef struct PageMap {
+    uint32_t num_pages;
+    std::atomic<int> *frames;
+} PageMap;
+
+/** One slice of the page table; all of a process's pages live in the shard picked by its PID **/
+typedef struct PageTableShard {
+    std::mutex lock;
+    std::unordered_map<uint64_t, PageTableEntry> table;
+    // Pages currently mapped by each process, so freeing only touches that process's footprint
+    std::unordered_map<uint32_t, std::vector<uint32_t> > process_pages;
+} PageTableShard;
+
+/** Maps (PID, page) pairs to frames. Safe to call from several threads: the table is split into shards by PID,
+    so processes in different shards never contend. Demand paging evicts across processes, so with it enabled
+    every call is additionally serialized on one paging lock (taken before any shard lock).
+    Without demand paging, translations take no page table locks at all: writers also publish each process's
+    mappings in a PageMap, which readers find through a two-level PID directory inside an epoch **/
 class PageTable {
 private:
+    static const int NUM_SHARDS = 64;
+    // The PID directory: high 16 bits pick a leaf, low 16 bits a process within it; leaves are made on first use
+    static const uint32_t DIRECTORY_SIZE = 1 << 16;
+
     int _page_size;
-    std::map<std::string, int> _table;
+    PageTableShard _shards[NUM_SHARDS];
+    std::unique_ptr<std::atomic<std::atomic<PageMap*>*>[]> _directory;
+    FrameAllocator _frames;
+    Tlb *_tlb;
+    // The TLB is not thread-safe itself; taken after a shard lock when both are needed
+    std::mutex _tlb_lock;
+    std::mutex _paging_lock;
+    // Demand paging (all NULL when pages are mapped up front): physical memory to copy pages in and out of,
+    // where evicted pages go, who picks the victim, and which page each frame holds
+    uint8_t *_memory;
+    SwapFile *_swap;
+    PageReplacer *_replacer;
+    std::vector<uint64_t> _frame_owner;
+    PagingStats _paging_stats;
 
-    std::vector<std::string> sortedKeys();
+    PageTableShard& shardOf(uint32_t pid);
+    int lookupFrame(PageTableShard &shard, uint32_t pid, int page_number, bool write);
+    int readFrame(uint32_t pid, int page_number);
+    int translateFrame(uint32_t pid, int page_number);
+    std::atomic<PageMap*>& pageMapSlot(uint32_t pid);
+    void publishFrame(uint32_t pid, int page_number, int frame);
+    void unpublishProcess(uint32_t pid);
+    int handleFault(uint64_t key, PageTableEntry &entry);
+    int evictPage(uint64_t incoming);
+    void releaseEntry(PageTableEntry &entry);
+    void printDemandPaged();
 
 public:
-    PageTable(int page_size);
+    PageTable(int page_size, uint64_t memory_size);
     ~PageTable();
 
-    void addEntry(uint32_t pid, int page_number);
-    int getPhysicalAddress(uint32_t pid, uint32_t virtual_address);
+    bool addEntry(uint32_t pid, int page_number);
+    void reserveEntry(uint32_t pid, int page_number);
+    uint64_t getPhysicalAddress(uint32_t pid, uint32_t virtual_address, bool write = false);
+    bool translateRange(uint32_t pid, uint32_t virtual_address, uint32_t length, std::vector<PhysicalExtent> &extents, bool write = false);
+    bool copyPaged(uint32_t pid, uint32_t virtual_address, uint8_t *buffer, uint32_t length, bool write);
     void print();
+    void printPagingStats();
     void freeAllPagesOfProcess(uint32_t pid);
     void freeSinglePage(uint32_t pid, int page);
     int getPageSize();
     int getPageNumber(uint32_t address);
-    
+    size_t getNumPagesOfProcess(uint32_t pid);
+    uint32_t getNumFrames();
+    uint32_t getFreeFrames();
+    void setTlb(Tlb *tlb);
+    Tlb* getTlb();
+    void enableDemandPaging(uint8_t *memory, SwapFile *swap, PageReplacer *replacer);
+    bool isDemandPaging();
+    PagingStats getPagingStats();
+    void getMappings(std::vector<PageMapping> &mappings);
+    bool restoreMapping(uint32_t pid, int page_number, int frame);
 };
 
 #endif // __PAGETABLE_H_
@@ -0,0 +1,26 @@
+#ifndef __PHYSICALMEMORY_H_
+#define __PHYSICALMEMORY_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <sys/types.h>
+
+/** Simulated physical memory: one anonymous mapping that the host only backs with RAM once a frame is touched **/
+class PhysicalMemory {
+private:
+    uint8_t *_base;
+    uint64_t _size;
+    bool _huge_pages;
+
+public:
+    PhysicalMemory(uint64_t size, bool huge_pages);
+    ~PhysicalMemory();
+
+    bool isMapped();
+    uint8_t* getBase();
+    uint64_t getSize();
+    uint64_t getResidentBytes();
+    bool mapImage(int fd, off_t offset);
+};
+
+#endif // __PHYSICALMEMORY_H_
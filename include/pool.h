@@ -0,0 +1,136 @@
+#ifndef __POOL_H_
+#define __POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <vector>
+#include <type_traits>
+#include <mutex>
+
+/** Hands out fixed-size slabs of raw memory and recycles the ones given back, so pools never go to malloc twice for the same slab.
+    Pools of different processes share one cache, so taking and giving back slabs is locked **/
+class SlabCache {
+private:
+    std::mutex _lock;
+    size_t _slab_bytes;
+    std::vector<void*> _all_slabs;
+    std::vector<void*> _free_slabs;
+
+public:
+    SlabCache(size_t slab_bytes) : _slab_bytes(slab_bytes) {}
+
+    ~SlabCache()
+    {
+        for (size_t i = 0; i < _all_slabs.size(); i++)
+        {
+            ::operator delete(_all_slabs[i]);
+        }
+    }
+
+    void* take()
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        if (!_free_slabs.empty())
+        {
+            void *slab = _free_slabs.back();
+            _free_slabs.pop_back();
+            return slab;
+        }
+        void *slab = ::operator new(_slab_bytes);
+        _all_slabs.push_back(slab);
+        return slab;
+    }
+
+    void give(void *slab)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _free_slabs.push_back(slab);
+    }
+
+    size_t getSlabBytes() { return _slab_bytes; }
+    size_t getNumSlabs() { return _all_slabs.size(); }
+    size_t getFreeSlabs() { return _free_slabs.size(); }
+};
+
+/** Allocates objects of type T out of slabs taken from a SlabCache, reusing freed slots through a free list **/
+template <typename T>
+class ObjectPool {
+private:
+    union Slot {
+        Slot *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    SlabCache *_cache;
+    std::vector<void*> _slabs;
+    size_t _slots_per_slab;
+    size_t _next_slot;
+    Slot *_free_list;
+    size_t _live;
+
+public:
+    ObjectPool(SlabCache *cache = NULL) : _cache(NULL), _slots_per_slab(0), _next_slot(0), _free_list(NULL), _live(0)
+    {
+        setCache(cache);
+    }
+
+    ~ObjectPool() { releaseAll(); }
+
+    /** Selects the cache slabs are drawn from; only valid while the pool holds no slabs **/
+    void setCache(SlabCache *cache)
+    {
+        _cache = cache;
+        _slots_per_slab = (cache != NULL) ? cache->getSlabBytes() / sizeof(Slot) : 0;
+        _next_slot = _slots_per_slab;
+    }
+
+    T* create()
+    {
+        Slot *slot;
+        if (_free_list != NULL)
+        {
+            slot = _free_list;
+            _free_list = slot->next;
+        }
+        else
+        {
+            if (_next_slot == _slots_per_slab)
+            {
+                _slabs.push_back(_cache->take());
+                _next_slot = 0;
+            }
+            slot = static_cast<Slot*>(_slabs.back()) + _next_slot;
+            _next_slot++;
+        }
+        _live++;
+        return new (&slot->storage) T();
+    }
+
+    void destroy(T *object)
+    {
+        object->~T();
+        Slot *slot = reinterpret_cast<Slot*>(object);
+        slot->next = _free_list;
+        _free_list = slot;
+        _live--;
+    }
+
+    /** Gives every slab back to the cache at once without visiting the objects in it; objects still live are not destroyed **/
+    void releaseAll()
+    {
+        for (size_t i = 0; i < _slabs.size(); i++)
+        {
+            _cache->give(_slabs[i]);
+        }
+        _slabs.clear();
+        _next_slot = _slots_per_slab;
+        _free_list = NULL;
+        _live = 0;
+    }
+
+    size_t getLive() { return _live; }
+    size_t getNumSlabs() { return _slabs.size(); }
+};
+
+#endif // __POOL_H_
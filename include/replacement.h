@@ -0,0 +1,187 @@
+#ifndef __REPLACEMENT_H_
+#define __REPLACEMENT_H_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <cstdint>
+
+enum ReplacementPolicy : uint8_t {Clock, Fifo, Lru, Lfu, Arc};
+
+/** Decides which resident frame gives up its page when demand paging runs out of free frames.
+    Pages are identified by their page table key, so policies can remember pages after they leave memory **/
+class PageReplacer {
+protected:
+    uint32_t _num_frames;
+
+public:
+    PageReplacer(uint32_t num_frames);
+    virtual ~PageReplacer();
+
+    // A page was just brought into frame
+    virtual void loaded(int frame, uint64_t page) = 0;
+    // The page in frame was read or written
+    virtual void accessed(int frame) = 0;
+    // The page in frame was written out to make room; it may be faulted back in later
+    virtual void evicted(int frame) = 0;
+    // The page in frame was unmapped for good
+    virtual void removed(int frame) = 0;
+    // Picks a resident frame to evict to make room for incoming, or -1 if nothing is resident; does not evict it
+    virtual int selectVictim(uint64_t incoming) = 0;
+    virtual const char* getName() = 0;
+
+    uint32_t getNumFrames();
+};
+
+/** Doubly linked list of frame numbers threaded through per-frame arrays, so every operation is O(1) **/
+class FrameList {
+private:
+    std::vector<int> _prev;
+    std::vector<int> _next;
+    std::vector<uint8_t> _member;
+    int _head;
+    int _tail;
+    uint32_t _size;
+
+public:
+    FrameList(uint32_t num_frames);
+
+    void pushBack(int frame);
+    void remove(int frame);
+    bool contains(int frame);
+    int front();
+    uint32_t size();
+};
+
+/** Second chance: a hand sweeps the frames, clearing reference bits, and evicts the first unreferenced page **/
+class ClockReplacer : public PageReplacer {
+private:
+    std::vector<uint8_t> _resident;
+    std::vector<uint8_t> _referenced;
+    uint32_t _num_resident;
+    uint32_t _hand;
+
+public:
+    ClockReplacer(uint32_t num_frames);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+/** Evicts the page that has been resident the longest, however often it is used **/
+class FifoReplacer : public PageReplacer {
+private:
+    FrameList _queue;
+
+public:
+    FifoReplacer(uint32_t num_frames);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+/** Evicts the least recently used page **/
+class LruReplacer : public PageReplacer {
+private:
+    // Least recently used at the front
+    FrameList _recency;
+
+public:
+    LruReplacer(uint32_t num_frames);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+/** Evicts the least frequently used page since it was loaded, least recently used first among ties **/
+class LfuReplacer : public PageReplacer {
+private:
+    std::vector<uint64_t> _count;
+    std::vector<uint64_t> _last_use;
+    // (use count, last use) of every resident frame, lowest first
+    std::set<std::pair<std::pair<uint64_t, uint64_t>, int> > _order;
+    uint64_t _clock;
+
+    void touch(int frame, uint64_t count);
+
+public:
+    LfuReplacer(uint32_t num_frames);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+/** Adaptive Replacement Cache (Megiddo and Modha): splits the frames between pages seen once (T1) and pages seen
+    again (T2), and moves the split towards whichever side's recently evicted pages (ghosts B1, B2) are missed **/
+class ArcReplacer : public PageReplacer {
+private:
+    FrameList _t1;
+    FrameList _t2;
+    // Ghost lists hold only page keys, most recently evicted at the back
+    std::list<uint64_t> _b1;
+    std::list<uint64_t> _b2;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> _b1_pages;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator> _b2_pages;
+    std::vector<uint64_t> _frame_page;
+    // Target size of T1
+    uint32_t _p;
+
+    void forget(std::list<uint64_t> &ghosts, std::unordered_map<uint64_t, std::list<uint64_t>::iterator> &pages);
+
+public:
+    ArcReplacer(uint32_t num_frames);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+/** Belady's optimal policy: evicts the page whose next use is furthest away. It needs the whole access sequence
+    up front, one page key per access in the order the page table will see them, so it only works offline **/
+class OptReplacer : public PageReplacer {
+private:
+    // For each position in the trace, the position of the next access to the same page (or the end of the trace)
+    std::vector<uint64_t> _next_use;
+    uint64_t _position;
+    std::vector<uint64_t> _frame_next;
+    std::set<std::pair<uint64_t, int> > _order;
+
+    void touch(int frame);
+
+public:
+    OptReplacer(uint32_t num_frames, const std::vector<uint64_t> &trace);
+
+    void loaded(int frame, uint64_t page);
+    void accessed(int frame);
+    void evicted(int frame);
+    void removed(int frame);
+    int selectVictim(uint64_t incoming);
+    const char* getName();
+};
+
+PageReplacer* createPageReplacer(ReplacementPolicy policy, uint32_t num_frames);
+bool parseReplacementPolicy(std::string name, ReplacementPolicy *policy);
+const char* replacementPolicyName(ReplacementPolicy policy);
+
+#endif // __REPLACEMENT_H_
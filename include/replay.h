@@ -0,0 +1,112 @@
+#ifndef __REPLAY_H_
+#define __REPLAY_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include "commands.h"
+
+/** How a command has to be ordered against the rest of the script **/
+enum ReplayKind : uint8_t {
+    ReplayLocal,    // only touches its own process (set, print/dump of a variable): ordered within its PID
+    ReplayOrdered,  // changes the process table, heaps or frames (create, allocate, free, terminate): also ordered against every other such command
+    ReplayBarrier   // reads or could affect the whole machine (print mmu, page, ...): everything before finishes first, nothing after starts until it is done
+};
+
+typedef struct ReplayCommand {
+    size_t offset;      // where the line starts in the window's text
+    size_t length;
+    uint32_t pid;
+    ReplayKind kind;
+    uint32_t rank;      // position among the ordered commands of its segment
+} ReplayCommand;
+
+/** Where one command's output sits in the buffer of the worker that ran it **/
+typedef struct ReplayOutput {
+    int worker;
+    size_t offset;
+    size_t length;
+} ReplayOutput;
+
+/** One PID's commands within a segment, run in order by whichever worker holds them **/
+typedef struct ReplayPartition {
+    std::vector<uint32_t> commands;
+    size_t next;
+} ReplayPartition;
+
+/** A worker's runnable partitions: the owner pops from the back, idle workers steal from the front **/
+typedef struct ReplayQueue {
+    std::mutex lock;
+    std::deque<uint32_t> partitions;
+} ReplayQueue;
+
+/** Replays a batch script on a pool of threads, one PID's commands at a time per thread, with the same output and
+    final state as running it serially. Commands are buffered into windows, and each window is cut into segments at
+    barrier commands; within a segment, partitions for different PIDs run in parallel, and only the ordered commands
+    wait on each other. Needs a machine without a TLB or demand paging, whose state depends on the global access order **/
+class ParallelReplay {
+private:
+    static const size_t WINDOW_SIZE = 65536;
+
+    Simulator *_sim;
+    int _num_workers;
+    std::vector<std::thread> _threads;
+    // Per-worker copies of the simulator, each writing into its own buffer
+    std::vector<Simulator> _workers;
+    std::vector<std::unique_ptr<std::ostringstream> > _buffers;
+    std::vector<std::unique_ptr<ReplayQueue> > _queues;
+    std::vector<Token> _tokens;
+
+    // The window being filled, its lines packed back to back, and each command's output once it has run
+    std::vector<ReplayCommand> _commands;
+    std::string _text;
+    std::vector<ReplayOutput> _outputs;
+    uint32_t _next_pid;
+
+    // The segment being run
+    std::vector<ReplayPartition> _partitions;
+    std::atomic<size_t> _remaining;
+    // Ordered commands run strictly by rank; a partition that reaches one early is parked until its turn
+    std::mutex _order_lock;
+    uint32_t _next_rank;
+    std::vector<int64_t> _parked;
+    // Idle workers sleep until a parked partition is put back in a queue (counted by _pushes) or the segment ends
+    std::mutex _idle_lock;
+    std::condition_variable _idle;
+    std::atomic<uint64_t> _pushes;
+
+    // Pool control: workers wake when the generation changes, and the last one out signals the main thread
+    std::mutex _pool_lock;
+    std::condition_variable _start;
+    std::condition_variable _finished;
+    uint64_t _generation;
+    int _running;
+    bool _stopping;
+
+    bool classify(ReplayCommand &command);
+    void run(Simulator *sim, uint32_t index);
+    void runWindow();
+    void runSegment(size_t begin, size_t end);
+    void work(int worker);
+    void workerLoop(int worker);
+    bool takePartition(int worker, uint32_t *partition);
+    void runPartition(int worker, uint32_t partition);
+    void execute(int worker, uint32_t index);
+
+public:
+    ParallelReplay(Simulator *sim, int num_threads);
+    ~ParallelReplay();
+
+    static bool supports(Simulator *sim);
+    void submit(const std::string &line);
+    void finish();
+};
+
+#endif // __REPLAY_H_
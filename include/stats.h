@@ -0,0 +1,68 @@
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/** Operations with a counter and a latency histogram **/
+enum StatOp : uint8_t {StatParse, StatLookup, StatAllocate, StatMap, StatTranslate, StatFree, StatTerminate, NUM_STAT_OPS};
+
+// Bucket k counts latencies in [2^k, 2^(k+1)) ns; bucket 0 also takes anything under 1 ns, the last one anything longer
+static const int NUM_STAT_BUCKETS = 40;
+
+typedef struct StatHistogram {
+    std::atomic<uint64_t> samples;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> buckets[NUM_STAT_BUCKETS];
+} StatHistogram;
+
+/** One thread's counters. Only the owning thread writes them, so updates are plain relaxed stores rather than
+    read-modify-writes, and threads never share a cache line; readers add up every thread's block **/
+typedef struct StatBlock {
+    std::atomic<uint64_t> counts[NUM_STAT_OPS];
+    StatHistogram histograms[NUM_STAT_OPS];
+} StatBlock;
+
+bool statsEnabled();
+bool statsCount(StatOp op);
+void statsRecord(StatOp op, uint64_t ns);
+void statsRecordTime(StatOp op, uint64_t ns);
+void printStats();
+bool writeStats(const std::string &path);
+
+/** Counts one operation and, if it is one of the sampled ones, times it until the end of the scope **/
+class StatTimer {
+private:
+    StatOp _op;
+    bool _timed;
+    std::chrono::steady_clock::time_point _start;
+
+public:
+    StatTimer(StatOp op) : _op(op)
+    {
+        _timed = statsCount(op);
+        if (_timed) { _start = std::chrono::steady_clock::now(); }
+    }
+
+    ~StatTimer()
+    {
+        if (_timed)
+        {
+            statsRecordTime(_op, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count());
+        }
+    }
+};
+
+// Instrumentation points compile to nothing unless built with MEMSIM_STATS (make STATS=1, the default)
+#ifdef MEMSIM_STATS
+#define STAT_SCOPE(op) StatTimer stat_timer(op)
+#define STAT_RECORD(op, ns) statsRecord(op, ns)
+#else
+#define STAT_SCOPE(op)
+#define STAT_RECORD(op, ns)
+#endif
+
+#endif // __STATS_H_
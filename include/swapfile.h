@@ -0,0 +1,29 @@
+#ifndef __SWAPFILE_H_
+#define __SWAPFILE_H_
+
+#include <string>
+#include <cstdint>
+#include "frameallocator.h"
+
+/** Backing store for evicted pages: a sparse file of page-sized slots **/
+class SwapFile {
+private:
+    int _fd;
+    uint32_t _slot_size;
+    // Slots are handed out exactly like frames, lowest free first
+    FrameAllocator _slots;
+
+public:
+    SwapFile(const std::string &path, uint32_t num_slots, uint32_t slot_size);
+    ~SwapFile();
+
+    bool isOpen();
+    int allocate();
+    void release(int slot);
+    bool write(int slot, const uint8_t *page);
+    bool read(int slot, uint8_t *page);
+    uint32_t getNumSlots();
+    uint32_t getFreeSlots();
+};
+
+#endif // __SWAPFILE_H_
@@ -0,0 +1,63 @@
+#ifndef __TLB_H_
+#define __TLB_H_
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+enum TlbPolicy : uint8_t {TlbLru, TlbFifo, TlbRandom};
+
+typedef struct TlbConfig {
+    uint32_t entries;
+    uint32_t ways;
+    TlbPolicy policy;
+    // true: entries are tagged with the PID (ASID); false: the TLB is flushed whenever the PID changes
+    bool asid_tagging;
+} TlbConfig;
+
+typedef struct TlbEntry {
+    bool valid;
+    uint32_t pid;
+    uint32_t page;
+    int frame;
+    uint64_t stamp;
+} TlbEntry;
+
+/** Set-associative cache of (pid, page) -> frame translations **/
+class Tlb {
+private:
+    TlbConfig _config;
+    uint32_t _num_sets;
+    std::vector<TlbEntry> _entries;
+    uint64_t _clock;
+    uint64_t _random_state;
+    uint32_t _current_pid;
+
+    uint64_t _hits;
+    uint64_t _misses;
+    uint64_t _evictions;
+    uint64_t _invalidations;
+    uint64_t _flushes;
+
+    TlbEntry* set(uint32_t pid, uint32_t page);
+
+public:
+    Tlb(TlbConfig config);
+    ~Tlb();
+
+    bool lookup(uint32_t pid, uint32_t page, int *frame);
+    void insert(uint32_t pid, uint32_t page, int frame);
+    void invalidate(uint32_t pid, uint32_t page);
+    void invalidateProcess(uint32_t pid);
+    void flush();
+    void print(int page_size);
+
+    uint64_t getHits();
+    uint64_t getMisses();
+    uint64_t getEvictions();
+};
+
+bool parseTlbPolicy(std::string name, TlbPolicy *policy);
+
+#endif // __TLB_H_
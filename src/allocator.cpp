@@ -0,0 +1,496 @@
+#include "allocator.h"
+#include <algorithm>
+
+HeapAllocator::HeapAllocator(uint32_t capacity)
+{
+    _capacity = capacity;
+    _free_bytes = 0;
+}
+
+HeapAllocator::~HeapAllocator()
+{
+}
+
+uint32_t HeapAllocator::reservedSize(uint32_t size) { return size; }
+
+uint32_t HeapAllocator::getCursor() { return 0; }
+
+void HeapAllocator::setCursor(uint32_t cursor)
+{
+}
+
+uint32_t HeapAllocator::getCapacity() { return _capacity; }
+
+uint32_t HeapAllocator::getFreeBytes() { return _free_bytes; }
+
+/** External fragmentation: share of the free bytes that can't be handed out as one block **/
+double HeapAllocator::getFragmentation()
+{
+    if (_free_bytes == 0)
+    {
+        return 0.0;
+    }
+    return 1.0 - (double)getLargestFreeBlock() / _free_bytes;
+}
+
+/** Whether saved blocks can be restored: non-empty, in address order, not overlapping and inside the heap **/
+bool HeapAllocator::checkBlocks(const HeapBlock *blocks, size_t count)
+{
+    uint64_t end = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (blocks[i].size == 0 || blocks[i].address < end || (uint64_t)blocks[i].address + blocks[i].size > _capacity)
+        {
+            return false;
+        }
+        end = (uint64_t)blocks[i].address + blocks[i].size;
+    }
+    return true;
+}
+
+FreeListAllocator::FreeListAllocator(uint32_t capacity) : HeapAllocator(capacity)
+{
+}
+
+/** Hooks for subclasses that keep extra indexes over the free blocks **/
+void FreeListAllocator::onInsert(uint32_t address, uint32_t size)
+{
+}
+
+void FreeListAllocator::onErase(uint32_t address, uint32_t size)
+{
+}
+
+void FreeListAllocator::insertBlock(uint32_t address, uint32_t size)
+{
+    _blocks[address] = size;
+    _free_bytes += size;
+    onInsert(address, size);
+}
+
+std::map<uint32_t, uint32_t>::iterator FreeListAllocator::eraseBlock(std::map<uint32_t, uint32_t>::iterator block)
+{
+    _free_bytes -= block->second;
+    onErase(block->first, block->second);
+    return _blocks.erase(block);
+}
+
+/** Carves size bytes from the start of a free block; whatever is left over stays free just after it **/
+void FreeListAllocator::take(std::map<uint32_t, uint32_t>::iterator block, uint32_t size, uint32_t *address)
+{
+    uint32_t block_address = block->first;
+    uint32_t block_size = block->second;
+    eraseBlock(block);
+    if (block_size > size)
+    {
+        insertBlock(block_address + size, block_size - size);
+    }
+    *address = block_address;
+}
+
+/** Returns [address, address + size) to the free blocks, coalescing with its neighbours **/
+void FreeListAllocator::release(uint32_t address, uint32_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    std::map<uint32_t, uint32_t>::iterator next = _blocks.lower_bound(address);
+
+    // Merge with the free block that starts right where this one ends
+    if (next != _blocks.end() && next->first == address + size)
+    {
+        size = size + next->second;
+        next = eraseBlock(next);
+    }
+
+    // Merge with the free block that ends right where this one starts
+    if (next != _blocks.begin())
+    {
+        std::map<uint32_t, uint32_t>::iterator prev = next;
+        --prev;
+        if (prev->first + prev->second == address)
+        {
+            address = prev->first;
+            size = size + prev->second;
+            eraseBlock(prev);
+        }
+    }
+
+    insertBlock(address, size);
+}
+
+uint32_t FreeListAllocator::getLargestFreeBlock()
+{
+    uint32_t largest = 0;
+    for (std::map<uint32_t, uint32_t>::iterator it = _blocks.begin(); it != _blocks.end(); ++it)
+    {
+        if (it->second > largest) { largest = it->second; }
+    }
+    return largest;
+}
+
+size_t FreeListAllocator::getNumFreeBlocks() { return _blocks.size(); }
+
+void FreeListAllocator::getFreeBlocks(std::vector<HeapBlock> &blocks)
+{
+    for (std::map<uint32_t, uint32_t>::iterator it = _blocks.begin(); it != _blocks.end(); ++it)
+    {
+        HeapBlock block = {it->first, it->second};
+        blocks.push_back(block);
+    }
+}
+
+/** Replaces the free blocks with a saved set, going through the hooks so subclass indexes are rebuilt too **/
+bool FreeListAllocator::restoreFreeBlocks(const HeapBlock *blocks, size_t count)
+{
+    if (!checkBlocks(blocks, count))
+    {
+        return false;
+    }
+    std::map<uint32_t, uint32_t>::iterator it = _blocks.begin();
+    while (it != _blocks.end())
+    {
+        it = eraseBlock(it);
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        insertBlock(blocks[i].address, blocks[i].size);
+    }
+    return true;
+}
+
+FirstFitAllocator::FirstFitAllocator(uint32_t capacity) : FreeListAllocator(capacity)
+{
+    insertBlock(0, capacity);
+}
+
+bool FirstFitAllocator::allocate(uint32_t size, uint32_t *address)
+{
+    for (std::map<uint32_t, uint32_t>::iterator it = _blocks.begin(); it != _blocks.end(); ++it)
+    {
+        if (it->second >= size)
+        {
+            take(it, size, address);
+            return true;
+        }
+    }
+    return false;
+}
+
+NextFitAllocator::NextFitAllocator(uint32_t capacity) : FreeListAllocator(capacity)
+{
+    _rover = 0;
+    insertBlock(0, capacity);
+}
+
+bool NextFitAllocator::allocate(uint32_t size, uint32_t *address)
+{
+    // Start with the block the rover points into (if it's free), then everything after it, then wrap around
+    std::map<uint32_t, uint32_t>::iterator start = _blocks.upper_bound(_rover);
+    if (start != _blocks.begin())
+    {
+        std::map<uint32_t, uint32_t>::iterator prev = start;
+        --prev;
+        if (prev->first + prev->second > _rover) { start = prev; }
+    }
+
+    std::map<uint32_t, uint32_t>::iterator it = start;
+    for (size_t visited = 0; visited < _blocks.size(); visited++)
+    {
+        if (it == _blocks.end()) { it = _blocks.begin(); }
+        if (it->second >= size)
+        {
+            take(it, size, address);
+            _rover = *address + size;
+            return true;
+        }
+        ++it;
+    }
+    return false;
+}
+
+uint32_t NextFitAllocator::getCursor() { return _rover; }
+
+void NextFitAllocator::setCursor(uint32_t cursor) { _rover = cursor; }
+
+BestFitAllocator::BestFitAllocator(uint32_t capacity) : FreeListAllocator(capacity)
+{
+    insertBlock(0, capacity);
+}
+
+void BestFitAllocator::onInsert(uint32_t address, uint32_t size)
+{
+    _by_size.insert(std::make_pair(size, address));
+}
+
+void BestFitAllocator::onErase(uint32_t address, uint32_t size)
+{
+    _by_size.erase(std::make_pair(size, address));
+}
+
+bool BestFitAllocator::allocate(uint32_t size, uint32_t *address)
+{
+    std::set<std::pair<uint32_t, uint32_t> >::iterator fit = _by_size.lower_bound(std::make_pair(size, 0u));
+    if (fit == _by_size.end())
+    {
+        return false;
+    }
+    take(_blocks.find(fit->second), size, address);
+    return true;
+}
+
+uint32_t BestFitAllocator::getLargestFreeBlock()
+{
+    return _by_size.empty() ? 0 : _by_size.rbegin()->first;
+}
+
+SegregatedAllocator::SegregatedAllocator(uint32_t capacity) : FreeListAllocator(capacity)
+{
+    insertBlock(0, capacity);
+}
+
+/** Size class k holds blocks of [2^k, 2^(k+1)) bytes **/
+int SegregatedAllocator::sizeClass(uint32_t size)
+{
+    return 31 - __builtin_clz(size);
+}
+
+void SegregatedAllocator::onInsert(uint32_t address, uint32_t size)
+{
+    _classes[sizeClass(size)].insert(address);
+}
+
+void SegregatedAllocator::onErase(uint32_t address, uint32_t size)
+{
+    _classes[sizeClass(size)].erase(address);
+}
+
+bool SegregatedAllocator::allocate(uint32_t size, uint32_t *address)
+{
+    int first = sizeClass(size > 0 ? size : 1);
+
+    // Blocks in the request's own class may still be too small, so that class is searched in address order
+    for (std::set<uint32_t>::iterator it = _classes[first].begin(); it != _classes[first].end(); ++it)
+    {
+        std::map<uint32_t, uint32_t>::iterator block = _blocks.find(*it);
+        if (block->second >= size)
+        {
+            take(block, size, address);
+            return true;
+        }
+    }
+
+    // Any block of a larger class fits; take the lowest-addressed one of the smallest such class
+    for (int c = first + 1; c < NUM_CLASSES; c++)
+    {
+        if (!_classes[c].empty())
+        {
+            take(_blocks.find(*_classes[c].begin()), size, address);
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t SegregatedAllocator::getLargestFreeBlock()
+{
+    for (int c = NUM_CLASSES - 1; c >= 0; c--)
+    {
+        if (!_classes[c].empty())
+        {
+            uint32_t largest = 0;
+            for (std::set<uint32_t>::iterator it = _classes[c].begin(); it != _classes[c].end(); ++it)
+            {
+                uint32_t size = _blocks[*it];
+                if (size > largest) { largest = size; }
+            }
+            return largest;
+        }
+    }
+    return 0;
+}
+
+BuddyAllocator::BuddyAllocator(uint32_t capacity) : HeapAllocator(capacity)
+{
+    _max_order = 31 - __builtin_clz(capacity);
+    _free_lists.resize(_max_order + 1);
+    _num_free_blocks = 0;
+
+    // Cover the address space with the largest aligned power-of-two blocks that fit
+    uint32_t address = 0;
+    for (int k = _max_order; k >= MIN_ORDER; k--)
+    {
+        if (capacity - address >= (1u << k))
+        {
+            _free_lists[k].insert(address);
+            _num_free_blocks++;
+            _free_bytes += (1u << k);
+            address += (1u << k);
+        }
+    }
+}
+
+/** Smallest block order that holds size bytes **/
+int BuddyAllocator::order(uint32_t size)
+{
+    int k = MIN_ORDER;
+    while (k < 32 && (1ull << k) < size)
+    {
+        k++;
+    }
+    return k;
+}
+
+uint32_t BuddyAllocator::reservedSize(uint32_t size)
+{
+    return 1u << order(size);
+}
+
+bool BuddyAllocator::allocate(uint32_t size, uint32_t *address)
+{
+    int k = order(size);
+    if (k > _max_order)
+    {
+        return false;
+    }
+
+    // Find the smallest non-empty order that can hold the request
+    int j = k;
+    while (j <= _max_order && _free_lists[j].empty())
+    {
+        j++;
+    }
+    if (j > _max_order)
+    {
+        return false;
+    }
+
+    uint32_t block = *_free_lists[j].begin();
+    _free_lists[j].erase(_free_lists[j].begin());
+    _num_free_blocks--;
+
+    // Split it in halves until it's the right order, keeping the upper halves free
+    while (j > k)
+    {
+        j--;
+        _free_lists[j].insert(block + (1u << j));
+        _num_free_blocks++;
+    }
+
+    _free_bytes -= (1u << k);
+    *address = block;
+    return true;
+}
+
+void BuddyAllocator::release(uint32_t address, uint32_t size)
+{
+    int k = order(size);
+    _free_bytes += (1u << k);
+
+    // Merge with the buddy for as long as the buddy is free too
+    while (k < _max_order)
+    {
+        uint32_t buddy = address ^ (1u << k);
+        std::set<uint32_t>::iterator it = _free_lists[k].find(buddy);
+        if (it == _free_lists[k].end())
+        {
+            break;
+        }
+        _free_lists[k].erase(it);
+        _num_free_blocks--;
+        address = address & ~(1u << k);
+        k++;
+    }
+
+    _free_lists[k].insert(address);
+    _num_free_blocks++;
+}
+
+uint32_t BuddyAllocator::getLargestFreeBlock()
+{
+    for (int k = _max_order; k >= MIN_ORDER; k--)
+    {
+        if (!_free_lists[k].empty()) { return 1u << k; }
+    }
+    return 0;
+}
+
+size_t BuddyAllocator::getNumFreeBlocks() { return _num_free_blocks; }
+
+void BuddyAllocator::getFreeBlocks(std::vector<HeapBlock> &blocks)
+{
+    size_t first = blocks.size();
+    for (int k = MIN_ORDER; k <= _max_order; k++)
+    {
+        for (std::set<uint32_t>::iterator it = _free_lists[k].begin(); it != _free_lists[k].end(); ++it)
+        {
+            HeapBlock block = {*it, 1u << k};
+            blocks.push_back(block);
+        }
+    }
+    std::sort(blocks.begin() + first, blocks.end(), [](const HeapBlock &a, const HeapBlock &b) { return a.address < b.address; });
+}
+
+/** Every saved block is a whole buddy block, so its size gives its order **/
+bool BuddyAllocator::restoreFreeBlocks(const HeapBlock *blocks, size_t count)
+{
+    if (!checkBlocks(blocks, count))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < count; i++)
+    {
+        int k = __builtin_ctz(blocks[i].size);
+        if (blocks[i].size != (1u << k) || k < MIN_ORDER || k > _max_order || blocks[i].address % blocks[i].size != 0)
+        {
+            return false;
+        }
+    }
+
+    for (int k = 0; k <= _max_order; k++)
+    {
+        _free_lists[k].clear();
+    }
+    _num_free_blocks = 0;
+    _free_bytes = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        _free_lists[__builtin_ctz(blocks[i].size)].insert(blocks[i].address);
+        _num_free_blocks++;
+        _free_bytes += blocks[i].size;
+    }
+    return true;
+}
+
+HeapAllocator* createHeapAllocator(AllocationPolicy policy, uint32_t capacity)
+{
+    switch (policy)
+    {
+        case AllocationPolicy::FirstFit: return new FirstFitAllocator(capacity);
+        case AllocationPolicy::NextFit: return new NextFitAllocator(capacity);
+        case AllocationPolicy::Segregated: return new SegregatedAllocator(capacity);
+        case AllocationPolicy::Buddy: return new BuddyAllocator(capacity);
+        case AllocationPolicy::BestFit:
+        default: return new BestFitAllocator(capacity);
+    }
+}
+
+/** Converts a policy name given on the command line into an AllocationPolicy **/
+bool parseAllocationPolicy(std::string name, AllocationPolicy *policy)
+{
+    if (name == "first") { *policy = AllocationPolicy::FirstFit; }
+    else if (name == "best") { *policy = AllocationPolicy::BestFit; }
+    else if (name == "next") { *policy = AllocationPolicy::NextFit; }
+    else if (name == "segregated") { *policy = AllocationPolicy::Segregated; }
+    else if (name == "buddy") { *policy = AllocationPolicy::Buddy; }
+    else { return false; }
+    return true;
+}
+
+const char* allocationPolicyName(AllocationPolicy policy)
+{
+    const char *names[] = {"first-fit", "best-fit", "next-fit", "segregated", "buddy"};
+    return names[policy];
+}
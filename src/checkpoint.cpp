@@ -0,0 +1,380 @@
+#include "checkpoint.h"
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char CHECKPOINT_MAGIC[8] = {'M', 'E', 'M', 'S', 'I', 'M', 'C', 'P'};
+static const uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+// Memory is written out in chunks of this size, skipping the ones that are all zeros
+static const size_t IMAGE_CHUNK = 65536;
+
+static uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+/** Lays the next section out after the previous one, 8-byte aligned **/
+static uint64_t placeSection(uint64_t *end, uint64_t size)
+{
+    uint64_t offset = alignUp(*end, 8);
+    *end = offset + size;
+    return offset;
+}
+
+static bool isZero(const uint8_t *data, size_t length)
+{
+    return length == 0 || (data[0] == 0 && memcmp(data, data + 1, length - 1) == 0);
+}
+
+static bool writeAll(int fd, const void *data, size_t length, uint64_t offset)
+{
+    const uint8_t *bytes = (const uint8_t*)data;
+    while (length > 0)
+    {
+        ssize_t written = pwrite(fd, bytes, length, (off_t)offset);
+        if (written <= 0)
+        {
+            return false;
+        }
+        bytes += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
+
+static bool readAll(int fd, void *data, size_t length, uint64_t offset)
+{
+    uint8_t *bytes = (uint8_t*)data;
+    while (length > 0)
+    {
+        ssize_t got = pread(fd, bytes, length, (off_t)offset);
+        if (got <= 0)
+        {
+            return false;
+        }
+        bytes += got;
+        length -= got;
+        offset += got;
+    }
+    return true;
+}
+
+/** Terminates every process, leaving the machine as it was at startup apart from the PID counter **/
+static void clearMachine(Simulator *sim)
+{
+    std::vector<uint32_t> pids = sim->mmu->getPids();
+    for (size_t i = 0; i < pids.size(); i++)
+    {
+        sim->mmu->removeProcess(pids[i]);
+        sim->page_table->freeAllPagesOfProcess(pids[i]);
+    }
+}
+
+/** Writes the whole machine to path: processes, variables, heaps, page mappings and the contents of physical memory.
+    The file is written next to path and renamed over it at the end, so a machine still running on an image mapped
+    from an older checkpoint at the same path keeps its own copy **/
+bool saveCheckpoint(Simulator *sim, const std::string &path, const char **error)
+{
+    if (sim->page_table->isDemandPaging() || sim->physical == NULL)
+    {
+        *error = "checkpoints need a machine without demand paging";
+        return false;
+    }
+    Mmu *mmu = sim->mmu;
+
+    // Gather every section in memory first; only the image is big, and it is written straight from physical memory
+    std::vector<CheckpointProcess> processes;
+    std::vector<CheckpointVariable> variables;
+    std::vector<HeapBlock> blocks;
+    std::vector<PageMapping> mappings;
+    std::string names;
+    std::vector<uint32_t> pids = mmu->getPids();
+    for (size_t i = 0; i < pids.size(); i++)
+    {
+        Process *proc = mmu->getProcess(pids[i]);
+        std::lock_guard<std::mutex> guard(proc->lock);
+        CheckpointProcess saved;
+        memset(&saved, 0, sizeof(saved));
+        saved.pid = proc->pid;
+        saved.used_bytes = proc->used_bytes;
+        saved.reserved_bytes = proc->reserved_bytes;
+        saved.heap_cursor = proc->heap->getCursor();
+        saved.num_variables = (uint32_t)proc->variables.size();
+
+        for (std::map<uint32_t, Variable*>::iterator it = proc->variables.begin(); it != proc->variables.end(); ++it)
+        {
+            const std::string &name = mmu->getVariableName(it->second);
+            CheckpointVariable var = {names.size(), (uint32_t)name.size(), it->second->type, it->second->virtual_address, it->second->size};
+            names.append(name);
+            variables.push_back(var);
+        }
+
+        size_t first_block = blocks.size();
+        proc->heap->getFreeBlocks(blocks);
+        saved.num_blocks = (uint32_t)(blocks.size() - first_block);
+        processes.push_back(saved);
+    }
+    sim->page_table->getMappings(mappings);
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.header_size = sizeof(CheckpointHeader);
+    header.page_size = sim->page_table->getPageSize();
+    header.memory_size = sim->physical->getSize();
+    header.policy = mmu->getAllocationPolicy();
+    header.first_pid = mmu->getFirstPid();
+    header.next_pid = mmu->getNextPid();
+    header.alloc_stats = mmu->getAllocatorStats();
+
+    uint64_t end = sizeof(CheckpointHeader);
+    header.num_processes = processes.size();
+    header.processes_offset = placeSection(&end, processes.size() * sizeof(CheckpointProcess));
+    header.num_variables = variables.size();
+    header.variables_offset = placeSection(&end, variables.size() * sizeof(CheckpointVariable));
+    header.num_blocks = blocks.size();
+    header.blocks_offset = placeSection(&end, blocks.size() * sizeof(HeapBlock));
+    header.num_mappings = mappings.size();
+    header.mappings_offset = placeSection(&end, mappings.size() * sizeof(PageMapping));
+    header.names_size = names.size();
+    header.names_offset = placeSection(&end, names.size());
+    header.memory_offset = alignUp(end, CHECKPOINT_IMAGE_ALIGN);
+
+    std::string temp_path = path + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        *error = "cannot create checkpoint file";
+        return false;
+    }
+
+    // Sizing the file up front leaves a hole wherever a chunk of memory isn't written, so untouched memory costs no disk
+    bool ok = ftruncate(fd, (off_t)(header.memory_offset + header.memory_size)) == 0 &&
+        writeAll(fd, &header, sizeof(header), 0) &&
+        writeAll(fd, processes.data(), processes.size() * sizeof(CheckpointProcess), header.processes_offset) &&
+        writeAll(fd, variables.data(), variables.size() * sizeof(CheckpointVariable), header.variables_offset) &&
+        writeAll(fd, blocks.data(), blocks.size() * sizeof(HeapBlock), header.blocks_offset) &&
+        writeAll(fd, mappings.data(), mappings.size() * sizeof(PageMapping), header.mappings_offset) &&
+        writeAll(fd, names.data(), names.size(), header.names_offset);
+
+    const uint8_t *memory = sim->physical->getBase();
+    for (uint64_t offset = 0; ok && offset < header.memory_size; offset += IMAGE_CHUNK)
+    {
+        size_t length = (size_t)std::min<uint64_t>(IMAGE_CHUNK, header.memory_size - offset);
+        if (!isZero(memory + offset, length))
+        {
+            ok = writeAll(fd, memory + offset, length, header.memory_offset + offset);
+        }
+    }
+
+    if (close(fd) != 0 || !ok || rename(temp_path.c_str(), path.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        *error = "cannot write checkpoint file";
+        return false;
+    }
+    return true;
+}
+
+/** Section [offset, offset + count * size) lies within the metadata, before the memory image **/
+static bool sectionFits(const CheckpointHeader *header, uint64_t offset, uint64_t count, uint64_t size)
+{
+    return offset % 8 == 0 && offset >= sizeof(CheckpointHeader) && offset <= header->memory_offset &&
+        count <= (header->memory_offset - offset) / size;
+}
+
+/** Checks the header and every record against the machine before it is touched: sections inside the file, processes
+    in the PID range, variables and mappings inside the process address space and not overlapping. A file that passes
+    can still contradict itself in ways only the restore finds out (free blocks over a variable, a frame mapped twice),
+    and that leaves an empty machine **/
+static const char* checkHeader(Simulator *sim, const CheckpointHeader *header, uint64_t file_size)
+{
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(header->magic)) != 0)
+    {
+        return "not a checkpoint file";
+    }
+    if (header->version != CHECKPOINT_VERSION || header->byte_order != CHECKPOINT_BYTE_ORDER ||
+        header->header_size != sizeof(CheckpointHeader))
+    {
+        return "checkpoint was saved by an incompatible version";
+    }
+    if (header->page_size != (uint32_t)sim->page_table->getPageSize())
+    {
+        return "checkpoint was saved with a different page size";
+    }
+    if (header->memory_size != sim->physical->getSize())
+    {
+        return "checkpoint was saved with a different memory size";
+    }
+    if (header->policy != sim->mmu->getAllocationPolicy())
+    {
+        return "checkpoint was saved with a different allocation policy";
+    }
+
+    bool fits = header->memory_offset % CHECKPOINT_IMAGE_ALIGN == 0 && header->memory_offset <= file_size &&
+        header->memory_size <= file_size - header->memory_offset && header->first_pid <= header->next_pid &&
+        sectionFits(header, header->processes_offset, header->num_processes, sizeof(CheckpointProcess)) &&
+        sectionFits(header, header->variables_offset, header->num_variables, sizeof(CheckpointVariable)) &&
+        sectionFits(header, header->blocks_offset, header->num_blocks, sizeof(HeapBlock)) &&
+        sectionFits(header, header->mappings_offset, header->num_mappings, sizeof(PageMapping)) &&
+        sectionFits(header, header->names_offset, header->names_size, 1);
+    if (!fits)
+    {
+        return "checkpoint file is corrupt";
+    }
+
+    // Processes by increasing PID inside the saved range, their runs of variables and blocks adding up to the sections,
+    // and no more bytes set aside than the process has, nor fewer than its variables hold
+    const uint8_t *base = (const uint8_t*)header;
+    const CheckpointProcess *processes = (const CheckpointProcess*)(base + header->processes_offset);
+    const CheckpointVariable *variables = (const CheckpointVariable*)(base + header->variables_offset);
+    const PageMapping *mappings = (const PageMapping*)(base + header->mappings_offset);
+    uint64_t process_size = sim->mmu->getProcessSize();
+    uint64_t num_variables = 0;
+    uint64_t num_blocks = 0;
+    for (uint64_t i = 0; i < header->num_processes; i++)
+    {
+        if (processes[i].pid < header->first_pid || processes[i].pid >= header->next_pid ||
+            (i > 0 && processes[i].pid <= processes[i - 1].pid) ||
+            processes[i].used_bytes > processes[i].reserved_bytes || processes[i].reserved_bytes > process_size)
+        {
+            return "checkpoint file is corrupt";
+        }
+        num_variables += processes[i].num_variables;
+        num_blocks += processes[i].num_blocks;
+    }
+    if (num_variables != header->num_variables || num_blocks != header->num_blocks)
+    {
+        return "checkpoint file is corrupt";
+    }
+
+    // Each process's variables in increasing address order, every one ending before the next starts and inside the
+    // address space; names inside the names section
+    const CheckpointVariable *var = variables;
+    for (uint64_t i = 0; i < header->num_processes; i++)
+    {
+        uint64_t previous_end = 0;
+        for (uint32_t v = 0; v < processes[i].num_variables; v++, var++)
+        {
+            uint64_t end = (uint64_t)var->virtual_address + var->size;
+            if (var->name_offset > header->names_size || var->name_length > header->names_size - var->name_offset ||
+                var->type < DataType::Char || var->type > DataType::Double ||
+                end > process_size || (v > 0 && var->virtual_address < previous_end) || var->size == 0)
+            {
+                return "checkpoint file is corrupt";
+            }
+            previous_end = end;
+        }
+    }
+
+    // Mapped pages inside the address space and frames inside physical memory
+    uint64_t num_pages = (process_size + header->page_size - 1) / header->page_size;
+    uint64_t num_frames = header->memory_size / header->page_size;
+    for (uint64_t i = 0; i < header->num_mappings; i++)
+    {
+        if (mappings[i].page >= num_pages || mappings[i].frame < 0 || (uint64_t)mappings[i].frame >= num_frames)
+        {
+            return "checkpoint file is corrupt";
+        }
+    }
+    return NULL;
+}
+
+/** Replaces the whole machine with the one saved in path. Metadata is read in place from a mapping of the file, and
+    physical memory is remapped onto the file's image copy-on-write, so only the frames the simulator touches
+    afterwards are ever read from disk. The TLB starts out empty **/
+bool loadCheckpoint(Simulator *sim, const std::string &path, const char **error)
+{
+    if (sim->page_table->isDemandPaging() || sim->physical == NULL)
+    {
+        *error = "checkpoints need a machine without demand paging";
+        return false;
+    }
+
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        if (fd >= 0) { close(fd); }
+        *error = "cannot open checkpoint file";
+        return false;
+    }
+    if ((uint64_t)info.st_size < sizeof(CheckpointHeader))
+    {
+        close(fd);
+        *error = "not a checkpoint file";
+        return false;
+    }
+
+    void *mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        close(fd);
+        *error = "cannot map checkpoint file";
+        return false;
+    }
+    const uint8_t *base = (const uint8_t*)mapped;
+    const CheckpointHeader *header = (const CheckpointHeader*)base;
+    *error = checkHeader(sim, header, info.st_size);
+    if (*error != NULL)
+    {
+        munmap(mapped, info.st_size);
+        close(fd);
+        return false;
+    }
+
+    const CheckpointProcess *processes = (const CheckpointProcess*)(base + header->processes_offset);
+    const CheckpointVariable *variables = (const CheckpointVariable*)(base + header->variables_offset);
+    const HeapBlock *blocks = (const HeapBlock*)(base + header->blocks_offset);
+    const PageMapping *mappings = (const PageMapping*)(base + header->mappings_offset);
+    const char *names = (const char*)(base + header->names_offset);
+
+    Mmu *mmu = sim->mmu;
+    clearMachine(sim);
+    mmu->restoreProcessTable(header->first_pid, header->next_pid, header->alloc_stats);
+
+    bool ok = true;
+    for (uint64_t i = 0; ok && i < header->num_processes; i++)
+    {
+        const CheckpointProcess &saved = processes[i];
+        Process *proc = mmu->restoreProcess(saved.pid, saved.reserved_bytes);
+        for (uint32_t v = 0; v < saved.num_variables; v++, variables++)
+        {
+            sim->name.assign(names + variables->name_offset, variables->name_length);
+            mmu->addVariableToProcess(proc, sim->name, (DataType)variables->type, variables->size, variables->virtual_address);
+        }
+
+        std::lock_guard<std::mutex> guard(proc->lock);
+        ok = proc->used_bytes == saved.used_bytes && proc->heap->restoreFreeBlocks(blocks, saved.num_blocks);
+        proc->heap->setCursor(saved.heap_cursor);
+        blocks += saved.num_blocks;
+    }
+    for (uint64_t i = 0; ok && i < header->num_mappings; i++)
+    {
+        ok = mmu->getProcess(mappings[i].pid) != NULL && sim->page_table->restoreMapping(mappings[i].pid, mappings[i].page, mappings[i].frame);
+    }
+
+    // Fall back on reading the image in if the file can't be mapped (some file systems don't support it)
+    if (ok && !sim->physical->mapImage(fd, (off_t)header->memory_offset))
+    {
+        ok = readAll(fd, sim->physical->getBase(), header->memory_size, header->memory_offset);
+    }
+
+    munmap(mapped, info.st_size);
+    close(fd);
+    if (!ok)
+    {
+        // Half a machine is worse than none
+        clearMachine(sim);
+        *error = "checkpoint file is corrupt";
+        return false;
+    }
+    return true;
+}
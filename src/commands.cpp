@@ -0,0 +1,765 @@
+#include "commands.h"
+#include "checkpoint.h"
+#include "stats.h"
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+
+/** Compares a token against a NUL-terminated string **/
+bool tokenEquals(Token token, const char *text)
+{
+    return strncmp(token.data, text, token.length) == 0 && text[token.length] == '\0';
+}
+
+/** Splits a line on a delimiter into views of the line (text in double quotes may contain the delimiter); returns the token count **/
+size_t tokenize(const char *line, size_t length, char delimiter, std::vector<Token> &tokens)
+{
+    enum states { NONE, IN_WORD, IN_STRING } state = NONE;
+    Token token = {line, 0};
+    tokens.clear();
+    for (size_t i = 0; i < length; i++)
+    {
+        char c = line[i];
+        switch (state) {
+            case NONE:
+                if (c != delimiter)
+                {
+                    if (c == '\"')
+                    {
+                        state = IN_STRING;
+                        token.data = line + i + 1;
+                    }
+                    else
+                    {
+                        state = IN_WORD;
+                        token.data = line + i;
+                    }
+                }
+                break;
+            case IN_WORD:
+                if (c == delimiter)
+                {
+                    token.length = (line + i) - token.data;
+                    tokens.push_back(token);
+                    state = NONE;
+                }
+                break;
+            case IN_STRING:
+                if (c == '\"')
+                {
+                    token.length = (line + i) - token.data;
+                    tokens.push_back(token);
+                    state = NONE;
+                }
+                break;
+        }
+    }
+    if (state != NONE)
+    {
+        token.length = (line + length) - token.data;
+        tokens.push_back(token);
+    }
+    return tokens.size();
+}
+
+/** Parses an optionally signed decimal integer that must span the whole token and fit in an int64_t **/
+bool parseInt64(Token token, int64_t *value)
+{
+    const char *p = token.data;
+    const char *end = token.data + token.length;
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = (*p == '-');
+        p++;
+    }
+    if (p == end)
+    {
+        return false;
+    }
+
+    // Magnitudes past the int64_t range are rejected rather than left to wrap
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    uint64_t result = 0;
+    for (; p < end; p++)
+    {
+        if (*p < '0' || *p > '9')
+        {
+            return false;
+        }
+        uint64_t digit = *p - '0';
+        if (result > (limit - digit) / 10)
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    *value = negative ? (int64_t)(0 - result) : (int64_t)result;
+    return true;
+}
+
+bool parseUInt32(Token token, uint32_t *value)
+{
+    int64_t result;
+    if (!parseInt64(token, &result) || result < 0 || result > 0xFFFFFFFFLL)
+    {
+        return false;
+    }
+    *value = (uint32_t)result;
+    return true;
+}
+
+/** Parses a floating point number that must span the whole token **/
+bool parseDouble(Token token, double *value)
+{
+    // strtod reads until it meets a character it can't use, and what follows a token is not always a delimiter
+    // (parallel replay packs lines back to back), so it gets a NUL-terminated copy of just the token
+    char buffer[64];
+    std::string long_token;
+    const char *text = buffer;
+    if (token.length < sizeof(buffer)) {
+        memcpy(buffer, token.data, token.length);
+        buffer[token.length] = '\0';
+    } else {
+        long_token.assign(token.data, token.length);
+        text = long_token.c_str();
+    }
+    char *end;
+    *value = strtod(text, &end);
+    return token.length > 0 && end == text + token.length;
+}
+
+/** Maps a type name from the command line onto a DataType **/
+bool parseDataType(Token token, DataType *type)
+{
+    static const struct { const char *name; DataType type; } types[] = {
+        {"char", DataType::Char}, {"short", DataType::Short}, {"int", DataType::Int},
+        {"float", DataType::Float}, {"long", DataType::Long}, {"double", DataType::Double}
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        if (tokenEquals(token, types[i].name))
+        {
+            *type = types[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void commandNotRecognized(Simulator *sim)
+{
+    *sim->out << "error: command not recognized" << "\n";
+}
+
+/** A translation failed: the page isn't mapped, or with demand paging there was no swap space left to evict to **/
+static void translationFailed(Simulator *sim)
+{
+    if (sim->page_table->isDemandPaging()) {
+        *sim->out << "error: out of swap space" << "\n";
+    } else {
+        *sim->out << "error: page not mapped" << "\n";
+    }
+}
+
+/** Parses one value of type T out of a token; values the type can't hold are rejected rather than truncated **/
+static bool parseValue(Token token, char *value) { *value = token.data[0]; return token.length > 0; }
+static bool parseValue(Token token, short *value) { int64_t v; if (!parseInt64(token, &v) || v < SHRT_MIN || v > SHRT_MAX) { return false; } *value = (short)v; return true; }
+static bool parseValue(Token token, int *value) { int64_t v; if (!parseInt64(token, &v) || v < INT_MIN || v > INT_MAX) { return false; } *value = (int)v; return true; }
+static bool parseValue(Token token, long *value) { int64_t v; if (!parseInt64(token, &v)) { return false; } *value = (long)v; return true; }
+static bool parseValue(Token token, float *value) { double v; if (!parseDouble(token, &v)) { return false; } *value = (float)v; return true; }
+static bool parseValue(Token token, double *value) { return parseDouble(token, value); }
+
+/** Parses every value into the staging buffer first, then writes them into the variable with one bulk copy **/
+template <typename T>
+static void setValues(Simulator *sim, uint32_t pid, Variable *var, uint32_t offset, const Token *values, size_t count)
+{
+    if ((uint64_t)offset + count > var->size / sizeof(T))
+    {
+        *sim->out << "error: index out of range" << "\n";
+        return;
+    }
+
+    sim->staging.resize(count * sizeof(T));
+    T *staged = (T*)sim->staging.data();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!parseValue(values[i], &staged[i]))
+        {
+            commandNotRecognized(sim);
+            return;
+        }
+    }
+    if (!setVariable(sim, pid, var, offset * sizeof(T), staged, count * sizeof(T)))
+    {
+        translationFailed(sim);
+    }
+}
+
+/** Copies length bytes between a buffer and a variable, starting at a byte offset; one translation per page **/
+static bool copyVariable(Simulator *sim, uint32_t pid, Variable *var, uint32_t offset, uint8_t *buffer, uint32_t length, bool write)
+{
+    // With demand paging, a frame only belongs to the page until the next fault evicts it, so the page table copies
+    // each page while it still holds the paging lock
+    uint32_t virtual_address = var->virtual_address + offset;
+    if (sim->page_table->isDemandPaging())
+    {
+        return sim->page_table->copyPaged(pid, virtual_address, buffer, length, write);
+    }
+
+    // Otherwise frames stay put for as long as the variable lives, so one range translation covers the whole copy
+    if (!sim->page_table->translateRange(pid, virtual_address, length, sim->extents, write))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sim->extents.size(); i++)
+    {
+        const PhysicalExtent &extent = sim->extents[i];
+        uint8_t *physical = (uint8_t*)sim->memory + (uint64_t)extent.frame * sim->page_size + extent.offset;
+        if (write) {
+            memcpy(physical, buffer, extent.length);
+        } else {
+            memcpy(buffer, physical, extent.length);
+        }
+        buffer += extent.length;
+    }
+    return true;
+}
+
+/** Copies length bytes of a variable, starting at a byte offset, into the staging buffer **/
+static bool readVariable(Simulator *sim, uint32_t pid, Variable *var, uint32_t offset, uint32_t length)
+{
+    sim->staging.resize(length);
+    return copyVariable(sim, pid, var, offset, sim->staging.data(), length, false);
+}
+
+
+/** Looks up a "<PID>:<var_name>" token, printing an error and returning NULL if either part doesn't resolve **/
+static Variable* resolveVariable(Simulator *sim, Token token, uint32_t *pid)
+{
+    const char *colon = (const char*)memchr(token.data, ':', token.length);
+    if (colon == NULL)
+    {
+        commandNotRecognized(sim);
+        return NULL;
+    }
+    Token pid_token = {token.data, (size_t)(colon - token.data)};
+    if (!parseUInt32(pid_token, pid))
+    {
+        commandNotRecognized(sim);
+        return NULL;
+    }
+    Process* proc = sim->mmu->getProcess(*pid);
+    if (proc == NULL)
+    {
+        *sim->out << "error: process not found" << "\n";
+        return NULL;
+    }
+    sim->name.assign(colon + 1, (token.data + token.length) - (colon + 1));
+    Variable* var = sim->mmu->getVariable(proc, sim->name);
+    if (var == NULL)
+    {
+        commandNotRecognized(sim);
+    }
+    return var;
+}
+
+/** Prints the first few elements of a variable, skipping unset (zero) ones after the first, then the element count **/
+template <typename T>
+static void printElements(std::ostream &out, const T *values, uint32_t shown, uint32_t total)
+{
+    for (uint32_t i = 0; i < shown; i++)
+    {
+        if (i == 0) {
+            out << values[i];
+        } else if (values[i] != 0) {
+            out << ", " << values[i];
+        }
+    }
+    if (shown == 4) {
+        out << ", ... [" << total << " items]";
+    }
+    out << "\n";
+}
+
+/** Prints every element of a chunk, comma separated **/
+template <typename T>
+static void dumpElements(std::ostream &out, const T *values, uint32_t count, bool first)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (!first || i > 0) {
+            out << ", ";
+        }
+        out << values[i];
+    }
+}
+
+/** create <text_size> <data_size> **/
+static void cmdCreate(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t text_size, data_size;
+    if (!parseUInt32(args[1], &text_size) || !parseUInt32(args[2], &data_size))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+    createProcess(sim, text_size, data_size);
+}
+
+/** allocate <PID> <var_name> <data_type> <number_of_elements> **/
+static void cmdAllocate(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t pid, num_elements;
+    DataType type;
+    if (!parseUInt32(args[1], &pid) || !parseDataType(args[3], &type) || !parseUInt32(args[4], &num_elements))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+
+    //check if process exists
+    if (sim->mmu->getProcess(pid) == NULL)
+    {
+        *sim->out << "error: process not found" << "\n";
+        return;
+    }
+    sim->name.assign(args[2].data, args[2].length);
+    allocateVariable(sim, pid, sim->name, type, num_elements);
+}
+
+/** set <PID> <var_name> <offset> <value_0> <value_1> ... <value_N> **/
+static void cmdSet(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t PID, offset;
+    if (!parseUInt32(args[1], &PID) || !parseUInt32(args[3], &offset))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+
+    // Look the process and the variable up once for the whole command
+    Process* proc = sim->mmu->getProcess(PID);
+    if (proc == NULL)
+    {
+        *sim->out << "error: process not found" << "\n";
+        return;
+    }
+    sim->name.assign(args[2].data, args[2].length);
+    Variable* curVar = sim->mmu->getVariable(proc, sim->name);
+    if (curVar == NULL)
+    {
+        *sim->out << "error: variable not found" << "\n";
+        return;
+    }
+
+    // Write every value passed in, starting from the 4th parameter
+    const Token *values = args + 4;
+    size_t num_values = count - 4;
+    switch (curVar->type)
+    {
+        case DataType::Char: setValues<char>(sim, PID, curVar, offset, values, num_values); break;
+        case DataType::Short: setValues<short>(sim, PID, curVar, offset, values, num_values); break;
+        case DataType::Int: setValues<int>(sim, PID, curVar, offset, values, num_values); break;
+        case DataType::Float: setValues<float>(sim, PID, curVar, offset, values, num_values); break;
+        case DataType::Long: setValues<long>(sim, PID, curVar, offset, values, num_values); break;
+        case DataType::Double: setValues<double>(sim, PID, curVar, offset, values, num_values); break;
+        default: break;
+    }
+}
+
+/** free <PID> <var_name> **/
+static void cmdFree(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t PID;
+    if (!parseUInt32(args[1], &PID))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+    sim->name.assign(args[2].data, args[2].length);
+    freeVariable(sim, PID, sim->name);
+}
+
+/** terminate <PID> **/
+static void cmdTerminate(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t PID;
+    if (!parseUInt32(args[1], &PID))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+    terminateProcess(sim, PID);
+}
+
+static void printMmu(Simulator *sim) { sim->mmu->print(); }
+static void printPage(Simulator *sim) { sim->page_table->print(); }
+static void printProcesses(Simulator *sim) { sim->mmu->printProcesses(); }
+static void printMemory(Simulator *sim)
+{
+    sim->mmu->printMemoryUsage();
+    if (sim->physical != NULL)
+    {
+        *sim->out << "Host: " << sim->physical->getResidentBytes() << " of " << sim->physical->getSize()
+            << " bytes of physical memory resident" << "\n";
+    }
+}
+static void printAlloc(Simulator *sim) { sim->mmu->printAllocatorStats(); }
+static void printStatistics(Simulator *sim) { printStats(); }
+
+static void printPaging(Simulator *sim)
+{
+    if (sim->page_table->isDemandPaging()) {
+        sim->page_table->printPagingStats();
+    } else {
+        *sim->out << "error: demand paging not enabled (start with --demand-paging)" << "\n";
+    }
+}
+
+static void printTlb(Simulator *sim)
+{
+    if (sim->tlb != NULL) {
+        sim->tlb->print(sim->page_size);
+    } else {
+        *sim->out << "error: TLB not enabled (start with --tlb <entries>)" << "\n";
+    }
+}
+
+/** print <object> **/
+static void cmdPrint(Simulator *sim, const Token *args, size_t count)
+{
+    static const struct { const char *object; void (*print)(Simulator *sim); } objects[] = {
+        {"mmu", printMmu},              // the MMU memory table
+        {"page", printPage},            // the page table (do not need to print anything for free frames)
+        {"processes", printProcesses},  // PIDs of processes that are still running
+        {"memory", printMemory},        // used and free bytes, system-wide and per process
+        {"alloc", printAlloc},          // allocation latency and fragmentation
+        {"tlb", printTlb},              // TLB hit/miss statistics
+        {"paging", printPaging},        // page faults, evictions and write-backs
+        {"stats", printStatistics}      // operation counts and latency histograms
+    };
+    for (size_t i = 0; i < sizeof(objects) / sizeof(objects[0]); i++)
+    {
+        if (tokenEquals(args[1], objects[i].object))
+        {
+            objects[i].print(sim);
+            return;
+        }
+    }
+
+    // If <object> is a "<PID>:<var_name>", print the value of the variable for that process
+    uint32_t PID;
+    Variable* curVar = resolveVariable(sim, args[1], &PID);
+    if (curVar != NULL)
+    {
+        printVariable(sim, PID, curVar);
+    }
+}
+
+/** dump <PID>:<var_name> [<start> [<count>]] **/
+static void cmdDump(Simulator *sim, const Token *args, size_t count)
+{
+    uint32_t PID;
+    Variable* curVar = resolveVariable(sim, args[1], &PID);
+    if (curVar == NULL)
+    {
+        return;
+    }
+
+    uint32_t elementSize = element_size(curVar->type);
+    uint32_t elements = curVar->size / elementSize;
+    uint32_t start = 0;
+    uint32_t num_elements = elements;
+    if ((count > 2 && !parseUInt32(args[2], &start)) || (count > 3 && !parseUInt32(args[3], &num_elements)))
+    {
+        commandNotRecognized(sim);
+        return;
+    }
+    if (start > elements)
+    {
+        *sim->out << "error: index out of range" << "\n";
+        return;
+    }
+    num_elements = std::min(num_elements, elements - start);
+
+    // Stream the slice through the staging buffer a bounded chunk at a time
+    uint32_t chunk_elements = std::max(1u, 65536u / elementSize);
+    for (uint32_t i = 0; i < num_elements; i += chunk_elements)
+    {
+        uint32_t n = std::min(chunk_elements, num_elements - i);
+        if (!readVariable(sim, PID, curVar, (start + i) * elementSize, n * elementSize))
+        {
+            translationFailed(sim);
+            return;
+        }
+        const void *values = sim->staging.data();
+        switch (curVar->type)
+        {
+            case DataType::Char: dumpElements(*sim->out, (const char*)values, n, i == 0); break;
+            case DataType::Short: dumpElements(*sim->out, (const short*)values, n, i == 0); break;
+            case DataType::Int: dumpElements(*sim->out, (const int*)values, n, i == 0); break;
+            case DataType::Float: dumpElements(*sim->out, (const float*)values, n, i == 0); break;
+            case DataType::Long: dumpElements(*sim->out, (const long*)values, n, i == 0); break;
+            case DataType::Double: dumpElements(*sim->out, (const double*)values, n, i == 0); break;
+            default: break;
+        }
+    }
+    *sim->out << "\n";
+}
+
+/** save <file> **/
+static void cmdSave(Simulator *sim, const Token *args, size_t count)
+{
+    const char *error;
+    sim->name.assign(args[1].data, args[1].length);
+    if (!saveCheckpoint(sim, sim->name, &error))
+    {
+        *sim->out << "error: " << error << "\n";
+    }
+}
+
+/** load <file> **/
+static void cmdLoad(Simulator *sim, const Token *args, size_t count)
+{
+    const char *error;
+    sim->name.assign(args[1].data, args[1].length);
+    if (!loadCheckpoint(sim, sim->name, &error))
+    {
+        *sim->out << "error: " << error << "\n";
+    }
+}
+
+/** Dispatch table: verb, minimum number of tokens including the verb, handler **/
+static const struct {
+    const char *verb;
+    size_t min_tokens;
+    void (*run)(Simulator *sim, const Token *args, size_t count);
+} commands[] = {
+    {"create", 3, cmdCreate},
+    {"allocate", 5, cmdAllocate},
+    {"set", 4, cmdSet},
+    {"free", 3, cmdFree},
+    {"terminate", 2, cmdTerminate},
+    {"print", 2, cmdPrint},
+    {"dump", 2, cmdDump},
+    {"save", 2, cmdSave},
+    {"load", 2, cmdLoad}
+};
+
+/** Tokenizes one command line in place and runs it **/
+void executeCommand(Simulator *sim, const char *line, size_t length)
+{
+    size_t count;
+    size_t command = sizeof(commands) / sizeof(commands[0]);
+    {
+        STAT_SCOPE(StatParse);
+        count = tokenize(line, length, ' ', sim->tokens);
+        if (count == 0)
+        {
+            return;
+        }
+        for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++)
+        {
+            if (tokenEquals(sim->tokens[0], commands[i].verb))
+            {
+                command = (count >= commands[i].min_tokens) ? i : command;
+                break;
+            }
+        }
+    }
+
+    if (command < sizeof(commands) / sizeof(commands[0]))
+    {
+        commands[command].run(sim, &sim->tokens[0], count);
+        return;
+    }
+
+    // Command not recognized
+    commandNotRecognized(sim);
+}
+
+/** Initializes a new process, prints its PID and returns it **/
+uint32_t createProcess(Simulator *sim, uint32_t text_size, uint32_t data_size)
+{
+    Mmu *mmu = sim->mmu;
+    // Create a new process in the MMU using the MMU's createProcess() method, which returns the current PID
+    uint32_t current_pid = mmu->createProcess();
+    // Allocate <TEXT> and <GLOBALS> variables for the newly created process using text_size and data_size;
+    // a process may have neither, and only a user's own empty allocation is an error
+    if(text_size > 0){
+        allocateVariable(sim, current_pid, "<TEXT>", Char, text_size);
+    }
+    if(data_size > 0){
+        allocateVariable(sim, current_pid, "<GLOBALS>", Char, data_size);
+    }
+    // Allocate <STACK> variable with a defined size of 65536
+    allocateVariable(sim, current_pid, "<STACK>", Char, 65536);
+    // Print the current PID to the console
+    *sim->out << current_pid << "\n";
+    return current_pid;
+}
+
+/** Allocates memory on the heap (how much depends on the data type and the number of elements), then prints the virtual memory address **/
+void allocateVariable(Simulator *sim, uint32_t pid, const std::string &var_name, DataType type, uint32_t num_elements)
+{
+    Mmu *mmu = sim->mmu;
+    PageTable *page_table = sim->page_table;
+    uint32_t theNewVariableSize;
+
+    // Computed in 64 bits so a huge element count can't wrap around to a small (or zero) size
+    uint64_t requested_size = (uint64_t)element_size(type) * num_elements;
+    if(requested_size > 0xFFFFFFFFULL){
+        *sim->out << "error: allocation would exceed system memory" << "\n";
+        return;
+    }
+    theNewVariableSize = (uint32_t)requested_size;
+
+    Process *proc = mmu->getProcess(pid);
+    if(mmu->getVariable(proc, var_name) != NULL){
+        *sim->out << "error: variable already exists" << "\n";
+        return;
+    }
+
+    // Zero-sized variables would share an address with whatever gets allocated next
+    if(theNewVariableSize == 0){
+        *sim->out << "error: variable must have at least one element" << "\n";
+        return;
+    }
+
+    // The MMU's allocator picks where the variable goes, according to the policy chosen at startup
+    Variable *newVariable = mmu->allocateVariable(proc, var_name, type, theNewVariableSize);
+    if(newVariable != NULL){
+        uint32_t addressOfFreeSpace = newVariable->virtual_address;
+
+        // Map every page the new variable touches
+        bool mapped = true;
+        if(theNewVariableSize > 0){
+            int pageNumber = page_table->getPageNumber(addressOfFreeSpace);
+            int endOfVariablePage = page_table->getPageNumber(addressOfFreeSpace + theNewVariableSize - 1);
+            for(int i = pageNumber; mapped && i <= endOfVariablePage; i++){
+                // With demand paging the page only gets a frame when it is first touched
+                if(page_table->isDemandPaging()){
+                    page_table->reserveEntry(pid, i);
+                }else{
+                    mapped = page_table->addEntry(pid, i);
+                }
+            }
+        }
+
+        // Frames can run out before the byte count does, since every process leaves its last pages partly empty.
+        // Undo the allocation: the pages only this variable touched are unmapped again, shared ones stay
+        if(!mapped){
+            std::vector<int> released_pages;
+            mmu->freeVariable(proc, newVariable, &released_pages);
+            for(size_t i = 0; i < released_pages.size(); i++){
+                page_table->freeSinglePage(pid, released_pages[i]);
+            }
+            *sim->out << "error: allocation would exceed system memory" << "\n";
+            return;
+        }
+
+        if(var_name != "<TEXT>" && var_name != "<GLOBALS>" && var_name != "<STACK>"){
+            *sim->out << addressOfFreeSpace << "\n";
+        }
+    }else{
+        *sim->out << "error: allocation would exceed system memory" << "\n";
+    }
+}
+
+/** Copies length bytes into a variable starting at a byte offset, translating once per page since consecutive pages need not sit in consecutive frames **/
+bool setVariable(Simulator *sim, uint32_t pid, Variable *current_var, uint32_t offset, const void *values, uint32_t length)
+{
+    return copyVariable(sim, pid, current_var, offset, (uint8_t*)values, length, true);
+}
+
+/** Deallocates memory on the heap that is associated with a variable **/
+void freeVariable(Simulator *sim, uint32_t pid, const std::string &var_name)
+{
+    Mmu *mmu = sim->mmu;
+    PageTable *page_table = sim->page_table;
+    // Check if the pid exists, if not, print an error and do nothing
+    // Remove entry from MMU by by changing the variable name and type to represent free space (using set()?)
+
+    Process* proc = mmu->getProcess(pid);
+    if(proc == NULL) {
+        *sim->out << "error: process not found" << "\n";
+        return;
+    }
+
+    // Check if variable exists, if not, print and error and do nothing
+    Variable* curVar = mmu->getVariable(proc, var_name);
+    if(curVar == NULL) {
+        *sim->out << "error: variable not found" << "\n";
+        return;
+    }
+
+    // Unmap the pages that no longer hold any variable
+    std::vector<int> released_pages;
+    mmu->freeVariable(proc, curVar, &released_pages);
+    for(int i=0; i < released_pages.size(); i++){
+        page_table->freeSinglePage(pid, released_pages[i]);
+    }
+}
+
+/** Kills the specified process and frees all memory associated with it **/
+void terminateProcess(Simulator *sim, uint32_t pid)
+{
+    STAT_SCOPE(StatTerminate);
+    Mmu *mmu = sim->mmu;
+    PageTable *page_table = sim->page_table;
+    // If the process does not exist, display a message and do nothing
+    if(mmu->getProcess(pid) == NULL) {
+        *sim->out << "error: process not found" << "\n";
+        return;
+    }
+    // Otherwise, remove the process from MMU
+    mmu->removeProcess(pid);
+    // Also free all pages associated with given process
+    page_table->freeAllPagesOfProcess(pid);
+}
+
+/** Prints the first four elements of a variable, reading them with a single range translation **/
+void printVariable(Simulator *sim, uint32_t pid, Variable *var)
+{
+    uint32_t elementSize = element_size(var->type);
+    uint32_t elements = var->size / elementSize;
+    uint32_t shown = std::min(elements, 4u);
+    if (!readVariable(sim, pid, var, 0, shown * elementSize))
+    {
+        translationFailed(sim);
+        return;
+    }
+
+    const void *values = sim->staging.data();
+    switch (var->type)
+    {
+        case DataType::Char: printElements(*sim->out, (const char*)values, shown, elements); break;
+        case DataType::Short: printElements(*sim->out, (const short*)values, shown, elements); break;
+        case DataType::Int: printElements(*sim->out, (const int*)values, shown, elements); break;
+        case DataType::Float: printElements(*sim->out, (const float*)values, shown, elements); break;
+        case DataType::Long: printElements(*sim->out, (const long*)values, shown, elements); break;
+        case DataType::Double: printElements(*sim->out, (const double*)values, shown, elements); break;
+        default: break;
+    }
+}
+
+int element_size(DataType type){
+    int elementSize = 0;
+    if(type == DataType::Char){
+        elementSize = 1;
+    }else if(type == DataType::Short){
+        elementSize = 2;
+    }else if(type == DataType::Int){
+        elementSize = 4;
+    }else if(type == DataType::Float){
+        elementSize = 4;
+    }else if(type == DataType::Double){
+        elementSize = 8;
+    }else if(type == DataType::Long){
+        elementSize = 8;
+    }
+    return elementSize;
+}
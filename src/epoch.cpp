@@ -0,0 +1,144 @@
+#include "epoch.h"
+
+EpochDomain::EpochDomain()
+{
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+        _slots[i].epoch.store(0);
+        _slots[i].claimed.store(false);
+    }
+    // Epoch 0 means "not reading", so counting starts at 1
+    _epoch.store(1);
+}
+
+/** Nobody can be reading once the domain itself goes away, so everything still retired is freed **/
+EpochDomain::~EpochDomain()
+{
+    for (size_t i = 0; i < _retired.size(); i++)
+    {
+        _retired[i].destroy(_retired[i].object);
+    }
+}
+
+/** Reserves a reader slot for the calling thread, returns -1 if they are all taken **/
+int EpochDomain::claimSlot()
+{
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+        bool expected = false;
+        if (!_slots[i].claimed.load(std::memory_order_relaxed) && _slots[i].claimed.compare_exchange_strong(expected, true))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void EpochDomain::releaseSlot(int slot)
+{
+    _slots[slot].epoch.store(0);
+    _slots[slot].claimed.store(false);
+}
+
+/** Publishes the current epoch in the reader's slot. Everything here is sequentially consistent on purpose: either a
+    writer scanning the slots sees this reader, or the reader is ordered after the writer's unlink and can't find the old object **/
+void EpochDomain::enter(int slot)
+{
+    _slots[slot].epoch.store(_epoch.load());
+}
+
+void EpochDomain::leave(int slot)
+{
+    _slots[slot].epoch.store(0, std::memory_order_release);
+}
+
+/** Queues an object that has already been unlinked, to be destroyed once every reader that might have seen it is done **/
+void EpochDomain::retire(void *object, void (*destroy)(void *object))
+{
+    std::lock_guard<std::mutex> guard(_retired_lock);
+    // Readers that enter from here on read a later epoch than this one, and can only find the replacement
+    Retired retired = {_epoch.fetch_add(1), destroy, object};
+    _retired.push_back(retired);
+    collectLocked();
+}
+
+/** Frees whatever retired objects no reader can still hold **/
+void EpochDomain::collect()
+{
+    std::lock_guard<std::mutex> guard(_retired_lock);
+    collectLocked();
+}
+
+void EpochDomain::collectLocked()
+{
+    // The oldest epoch any reader is still in; objects retired before it are unreachable
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < MAX_READERS; i++)
+    {
+        uint64_t epoch = _slots[i].epoch.load();
+        if (epoch != 0 && epoch < oldest)
+        {
+            oldest = epoch;
+        }
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < _retired.size(); i++)
+    {
+        if (_retired[i].epoch < oldest)
+        {
+            _retired[i].destroy(_retired[i].object);
+        }
+        else
+        {
+            _retired[kept++] = _retired[i];
+        }
+    }
+    _retired.resize(kept);
+}
+
+/** The domain every page table shares, so a thread only ever needs one slot **/
+EpochDomain& EpochDomain::global()
+{
+    static EpochDomain domain;
+    return domain;
+}
+
+/** The calling thread's slot and how deeply its guards are nested; the slot goes back to the domain when the thread exits **/
+typedef struct ReaderState {
+    int slot;
+    int depth;
+    bool claimed;
+
+    ~ReaderState()
+    {
+        if (slot >= 0)
+        {
+            EpochDomain::global().releaseSlot(slot);
+        }
+    }
+} ReaderState;
+
+static thread_local ReaderState reader = {-1, 0, false};
+
+EpochGuard::EpochGuard()
+{
+    if (!reader.claimed)
+    {
+        reader.slot = EpochDomain::global().claimSlot();
+        reader.claimed = true;
+    }
+    _slot = reader.slot;
+    if (_slot >= 0 && reader.depth++ == 0)
+    {
+        EpochDomain::global().enter(_slot);
+    }
+}
+
+EpochGuard::~EpochGuard()
+{
+    if (_slot >= 0 && --reader.depth == 0)
+    {
+        EpochDomain::global().leave(_slot);
+    }
+}
@@ -0,0 +1,112 @@
+#include "frameallocator.h"
+#include <algorithm>
+
+static inline uint32_t searchWord(uint64_t search) { return (uint32_t)search; }
+static inline uint64_t searchWithWord(uint64_t search, uint32_t word) { return (search & ~0xFFFFFFFFULL) | word; }
+
+FrameAllocator::FrameAllocator(uint32_t num_frames) : _free_frames(num_frames), _search(0)
+{
+    _num_frames = num_frames;
+    _num_words = (num_frames + 63) / 64;
+    _used.reset(new std::atomic<uint64_t>[_num_words]);
+    for (uint32_t i = 0; i < _num_words; i++)
+    {
+        _used[i].store(0);
+    }
+
+    // Frames past the end of physical memory in the last word are never handed out
+    if (num_frames % 64 != 0)
+    {
+        _used[_num_words - 1].store(~0ULL << (num_frames % 64));
+    }
+}
+
+FrameAllocator::~FrameAllocator()
+{
+}
+
+/** Returns the lowest free frame number and marks it used, or -1 if physical memory is full **/
+int FrameAllocator::allocate()
+{
+    if (_free_frames.load() == 0)
+    {
+        return -1;
+    }
+
+    // Every word below the search word is full, so skip them a whole word at a time
+    uint64_t search = _search.load();
+    uint32_t hint = searchWord(search);
+    for (uint32_t word = hint; word < _num_words; word++)
+    {
+        // Claim a bit with compare-and-swap; if another thread got there first, look at the word again
+        uint64_t bits = _used[word].load();
+        while (bits != ~0ULL)
+        {
+            int bit = __builtin_ctzll(~bits);
+            if (_used[word].compare_exchange_weak(bits, bits | (1ULL << bit)))
+            {
+                _free_frames--;
+                // Only move the hint up if nothing was released since the scan began: a frame freed in a word
+                // already passed over would otherwise end up below the hint, where no allocation looks
+                if (word != hint)
+                {
+                    _search.compare_exchange_strong(search, searchWithWord(search, word));
+                }
+                return (int)(word * 64 + bit);
+            }
+        }
+    }
+    return -1;
+}
+
+/** Returns a frame to the free pool so the next allocation can reuse it **/
+void FrameAllocator::release(int frame)
+{
+    if (frame < 0 || (uint32_t)frame >= _num_frames)
+    {
+        return;
+    }
+
+    uint32_t word = frame / 64;
+    uint64_t mask = 1ULL << (frame % 64);
+    if ((_used[word].fetch_and(~mask) & mask) == 0)
+    {
+        // Wasn't allocated
+        return;
+    }
+    _free_frames++;
+
+    // Count the release even when the hint stays put, so an allocation scanning past this word won't raise it
+    uint64_t search = _search.load();
+    uint64_t updated;
+    do
+    {
+        updated = searchWithWord(search + (1ULL << 32), std::min(word, searchWord(search)));
+    } while (!_search.compare_exchange_weak(search, updated));
+}
+
+/** Marks one particular frame used, as when a checkpoint is restored; returns false if it is out of range or already taken **/
+bool FrameAllocator::claim(int frame)
+{
+    if (frame < 0 || (uint32_t)frame >= _num_frames)
+    {
+        return false;
+    }
+
+    uint64_t mask = 1ULL << (frame % 64);
+    if ((_used[frame / 64].fetch_or(mask) & mask) != 0)
+    {
+        return false;
+    }
+    _free_frames--;
+    return true;
+}
+
+bool FrameAllocator::isAllocated(int frame)
+{
+    return (_used[frame / 64].load() >> (frame % 64)) & 1ULL;
+}
+
+uint32_t FrameAllocator::getNumFrames(){ return _num_frames; }
+
+uint32_t FrameAllocator::getFreeFrames(){ return _free_frames.load(); }
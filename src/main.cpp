@@ -2,19 +2,26 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cerrno>
+#include <fstream>
+#include <chrono>
 #include "mmu.h"
 #include "pagetable.h"
+#include "tlb.h"
+#include "allocator.h"
+#include "commands.h"
+#include "physicalmemory.h"
+#include "swapfile.h"
+#include "replacement.h"
+#include "replay.h"
+#include "checkpoint.h"
+#include "stats.h"
 
 /** Prototypes **/
 void printStartMessage(int page_size);
-void createProcess(int text_size, int data_size, Mmu *mmu, PageTable *page_table);
-void allocateVariable(uint32_t pid, std::string var_name, DataType type, uint32_t num_elements, Mmu *mmu, PageTable *page_table);
-void setVariable(uint32_t pid, std::string var_name, uint32_t offset, void *value, Mmu *mmu, PageTable *page_table, void *memory);
-void freeVariable(uint32_t pid, std::string var_name, Mmu *mmu, PageTable *page_table);
-void terminateProcess(uint32_t pid, Mmu *mmu, PageTable *page_table);
-void splitString(std::string text, char d, std::vector<std::string>& result);
-int element_size(DataType type);
-void printValue(uint32_t pid, std::string var_name, uint32_t offset, void *value, void *memory);
+bool readCommand(std::istream &input, std::string &command, bool prompt);
+bool parseMemorySize(const char *text, uint64_t *size);
+bool parseCount(const char *text, long min, long max, uint32_t *count);
 
 /** Main function **/
 int main(int argc, char **argv)
@@ -27,350 +34,271 @@ int main(int argc, char **argv)
     }
 
     // Print opening instuction message
-    int page_size = std::stoi(argv[1]);
-    printStartMessage(page_size);
-
-    // Create physical 'memory' of 64 MB (64 * 1024 * 1024)
-    uint32_t mem_size = 67108864;
-    void *memory = malloc(mem_size);
-
-    // Create MMU and Page Table
-    Mmu *mmu = new Mmu(mem_size);
-    PageTable *page_table = new PageTable(page_size);
-    
-    // Prompt loop
-    std::string command;
-    std::vector<std::string> command_parameters;
-    std::cout << "> ";
-    std::getline (std::cin, command);
-
-    // Handle current command
-    while (command != "exit") {
-        
-        // Split the command into space-delimited arguments stored in the command_parameters vector
-        splitString(command, ' ', command_parameters);
-
-        // Parse create() arguments
-        if(command_parameters[0] == "create") {
-            int text_size = std::stoi(command_parameters[1]);
-            int data_size = std::stoi(command_parameters[2]);
-            createProcess(text_size, data_size, mmu, page_table);
-
-        // Parse allocate() arguments
-        } else if(command_parameters[0] == "allocate") {
-            uint32_t pid = atoi(command_parameters[1].c_str());
-
-            //check if process exists
-            if(mmu->findProcess(pid)){
-            std::string var_name = command_parameters[2];
-            DataType type;
-                if(command_parameters[3] == "char"){
-                    type = DataType::Char;
-                }else if(command_parameters[3] == "int"){
-                type = DataType::Int;
-                }else if(command_parameters[3] == "short"){
-                    type = DataType::Short;
-                }else if(command_parameters[3] == "float"){
-                    type = DataType::Float;
-                }else if(command_parameters[3] == "double"){
-                    type = DataType::Double;
-                }else if(command_parameters[3] == "long"){
-                    type = DataType::Long;
-                }
-            uint32_t num_elements = atoi(command_parameters[4].c_str());
-            allocateVariable(pid, var_name, type, num_elements, mmu, page_table);
-            }else{
-                std::cout << "error: process not found" << std::endl;
+    uint32_t page_size_arg;
+    if (!parseCount(argv[1], 1, 0x7FFFFFFF, &page_size_arg))
+    {
+        fprintf(stderr, "Error: invalid page size '%s'\n", argv[1]);
+        return 1;
+    }
+    int page_size = (int)page_size_arg;
+
+    // Optional TLB configuration: --tlb <entries> [--tlb-ways <n>] [--tlb-policy lru|fifo|random] [--tlb-flush]
+    TlbConfig tlb_config = {0, 4, TlbPolicy::TlbLru, true};
+    // Heap allocation policy: --alloc first|best|next|segregated|buddy
+    AllocationPolicy alloc_policy = AllocationPolicy::BestFit;
+    // Batch mode: --batch <file|-> replays a command script without prompts; --quiet drops command output;
+    //             --jobs <N> replays commands for different PIDs on N threads
+    const char *batch_path = NULL;
+    bool quiet = false;
+    uint32_t jobs = 1;
+    // Physical memory: --memory <bytes>[K|M|G] (default 64M) [--hugepages]
+    uint64_t mem_size = 67108864;
+    bool huge_pages = false;
+    // Demand paging: --demand-paging [--swap <bytes>[K|M|G]] (default 4x memory) [--swap-file <path>]
+    //                [--replacement clock|fifo|lru|lfu|arc]
+    bool demand_paging = false;
+    uint64_t swap_size = 0;
+    const char *swap_path = "memsim.swap";
+    ReplacementPolicy replacement = ReplacementPolicy::Clock;
+    // Checkpoint to start from: --load <file>, saved with "save" on a machine with the same page size, memory and --alloc
+    const char *load_path = NULL;
+    // Operation counts and latency histograms written at exit: --stats <file> (CSV if it ends in .csv, JSON otherwise)
+    const char *stats_path = NULL;
+    for (int i = 2; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--tlb" && i + 1 < argc) {
+            if (!parseCount(argv[++i], 0, 1 << 24, &tlb_config.entries)) {
+                fprintf(stderr, "Error: invalid TLB size '%s'\n", argv[i]);
+                return 1;
             }
-
-        // Parse set() arguments
-        } else if(command_parameters[0] == "set") {
-
-            uint32_t PID = std::stoi(command_parameters[1]);
-            std::string var_name = command_parameters[2];
-            int offset = std::stoi(command_parameters[3]);
-            Variable* curVar = mmu->getVariable(PID, var_name);
-            int nextElementOffset = 0;
-
-            // Check if the pid exists, if not, print an error and do nothing
-            if(!mmu->findProcess(PID)) {
-            std::cout << "error: process not found" << std::endl;
-            }else{
-                // Check if the variable exists, if not, print an error and do nothing
-                if(mmu->findVariable(PID, var_name)) {
-                    if(curVar->type == DataType::Char){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            char val = command_parameters[i].at(0);
-                            setVariable(PID, var_name, (offset + nextElementOffset)* 1, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }else if(curVar->type == DataType::Int){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            int val = std::stoi(command_parameters[i]);
-                            setVariable(PID, var_name, (offset + nextElementOffset) * 4, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }else if(curVar->type == DataType::Short){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            short val = std::stoi(command_parameters[i]);
-                            setVariable(PID, var_name, (offset + nextElementOffset) * 2, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }else if(curVar->type == DataType::Float){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            float val = std::stof(command_parameters[i]);
-                            setVariable(PID, var_name, (offset + nextElementOffset) * 4, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }else if(curVar->type == DataType::Double){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            double val = std::stod(command_parameters[i]);
-                            setVariable(PID, var_name, (offset + nextElementOffset) * 8, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }else if(curVar->type == DataType::Long){
-                        for(int i = 4; i < command_parameters.size(); i++) {
-                            long val = std::stol(command_parameters[i]);
-                            setVariable(PID, var_name, (offset + nextElementOffset) * 8, &val, mmu, page_table, memory);
-                            nextElementOffset++;
-                        }
-                    }
-                }else{
-                    std::cout << "error: variable not found" << std::endl;
-                }
-
+        } else if (option == "--tlb-ways" && i + 1 < argc) {
+            if (!parseCount(argv[++i], 1, 1 << 24, &tlb_config.ways)) {
+                fprintf(stderr, "Error: invalid TLB associativity '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--tlb-policy" && i + 1 < argc) {
+            if (!parseTlbPolicy(argv[++i], &tlb_config.policy)) {
+                fprintf(stderr, "Error: unknown TLB policy '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--alloc" && i + 1 < argc) {
+            if (!parseAllocationPolicy(argv[++i], &alloc_policy)) {
+                fprintf(stderr, "Error: unknown allocation policy '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--batch" && i + 1 < argc) {
+            batch_path = argv[++i];
+        } else if (option == "--jobs" && i + 1 < argc) {
+            if (!parseCount(argv[++i], 1, 1024, &jobs)) {
+                fprintf(stderr, "Error: invalid job count '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--memory" && i + 1 < argc) {
+            if (!parseMemorySize(argv[++i], &mem_size)) {
+                fprintf(stderr, "Error: invalid memory size '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--hugepages") {
+            huge_pages = true;
+        } else if (option == "--demand-paging") {
+            demand_paging = true;
+        } else if (option == "--swap" && i + 1 < argc) {
+            if (!parseMemorySize(argv[++i], &swap_size)) {
+                fprintf(stderr, "Error: invalid swap size '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--swap-file" && i + 1 < argc) {
+            swap_path = argv[++i];
+        } else if (option == "--replacement" && i + 1 < argc) {
+            if (!parseReplacementPolicy(argv[++i], &replacement)) {
+                fprintf(stderr, "Error: unknown replacement policy '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (option == "--load" && i + 1 < argc) {
+            load_path = argv[++i];
+        } else if (option == "--stats" && i + 1 < argc) {
+            stats_path = argv[++i];
+        } else if (option == "--quiet") {
+            quiet = true;
+        } else if (option == "--tlb-flush") {
+            tlb_config.asid_tagging = false;
+        } else {
+            fprintf(stderr, "Error: unrecognized option '%s'\n", argv[i]);
+            return 1;
         }
-            
-            // Call setVariable() for all n values passed in, starting from the 4th parameter and ending at the size of the vector
-
-
-        // Parse free() arguments
-        } else if(command_parameters[0] == "free") {
-            uint32_t PID = std::stoi(command_parameters[1]);
-            std::string var_name = command_parameters[2];
-            freeVariable(PID, var_name, mmu, page_table);
-
-        // Parse terminate() arguments 
-        } else if(command_parameters[0] == "terminate") {
-            uint32_t PID = std::stoi(command_parameters[1]);
-            terminateProcess(PID, mmu, page_table);
-
-        // Parse print() arguments
-        } else if(command_parameters[0] == "print") {
-            std::string object = command_parameters[1];
-            if(object == "mmu") {
-                // Print the MMU memory table
-                mmu->print();
-
-            } else if(object == "page") {
-                // Print the page table (do not need to print anything for free frames)
-                page_table->print();
-
-            } else if(object == "processes") {
-                // Print a list of PIDs for processes that are still running
-                mmu->printProcesses();
-
-            } else {
-                // If <object> is a "<PID>:<var_name>", print the value of the variable for that process 
-                std::vector<std::string> print_process_arguments;
-                splitString(object, ':', print_process_arguments);
-                try {
-                    uint32_t PID = std::stoi(print_process_arguments[0]);
-                    std::string var_name = print_process_arguments[1];
-                    Variable* curVar = mmu->getVariable(PID, var_name);
-                    uint32_t elementSize = element_size(curVar->type);
-                    int curVarElements = (curVar->size)/elementSize;
-
-                    if(!mmu->findProcess(PID)) {
-                        std::cout << "error: process not found" << std::endl;
-                    } else if(!mmu->findVariable(PID, var_name)) {
-                        std::cout << "error: command not recognized" << std::endl;
-                    } else {
-                        int counter = 0;
-                    switch (curVar->type) {
-
-                        case DataType::Char:
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            char curChar;
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
-
-                            memcpy(&curChar, (uint8_t*)memory + physical_address + i, elementSize);
-
-
-                            if(i == 0){
-                                std::cout << curChar;
-                                counter++;
-                            }else{
-                                if(curChar != NULL && counter < 4){
-                                    std::cout << ", " << curChar;
-                                }
-                                counter++;
-                            }
-
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }
-                        std::cout << std::endl;
-                        break;
-
-                        case DataType::Int:
-
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            int curInt;
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
-                            memcpy(&curInt, (uint8_t*)memory + physical_address + i, elementSize);
-                            if(i == 0){
-                                std::cout << curInt;
-                                counter++;
-                            }else{
-                                if(curInt != NULL && counter < 4){
-                                    std::cout << ", " << curInt;
-                                }
-                                counter++;
-                            }
-
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }    
-                        std::cout << std::endl;                    
-                        break;
-
-                        case DataType::Short:
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            short curShort;
-                            uint32_t elementSize = element_size(curVar->type);
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
-
-                            memcpy(&curShort, (uint8_t*)memory + physical_address + i, elementSize);
-                            if(i == 0){
-                                std::cout << curShort;
-                                counter++;
-                            }else{
-                                if(curShort != NULL && counter < 4){
-                                    std::cout << ", " << curShort;
-                                }
-                                counter++;
-                            }
-
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }        
-                        std::cout << std::endl;                
-                        break;
-
-                        case DataType::Float:
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            float curFloat;
-                            uint32_t elementSize = element_size(curVar->type);
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
-
-                            memcpy(&curFloat, (uint8_t*)memory + physical_address + i, elementSize);
-                            std::cout << curFloat << ", ";
-                            if(i == 0){
-                                std::cout << curFloat;
-                                counter++;
-                            }else{
-                                if(curFloat != NULL && counter < 4){
-                                    std::cout << ", " << curFloat;
-                                }
-                                counter++;
-                            }
-
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }     
-                        std::cout << std::endl;                   
-                        break;
+    }
 
-                        case DataType::Double:
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            double curDouble;
-                            uint32_t elementSize = element_size(curVar->type);
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
+    // In batch mode, read commands from the script (or stdin for "-") and fully buffer the output
+    std::ifstream batch_file;
+    std::istream *input = &std::cin;
+    if (batch_path != NULL)
+    {
+        if (std::string(batch_path) != "-")
+        {
+            batch_file.open(batch_path);
+            if (!batch_file)
+            {
+                fprintf(stderr, "Error: cannot open batch file '%s'\n", batch_path);
+                return 1;
+            }
+            input = &batch_file;
+        }
+        setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+    }
+    else
+    {
+        printStartMessage(page_size);
+    }
 
-                            memcpy(&curDouble, (uint8_t*)memory + physical_address + i, elementSize);
-                            if(i == 0){
-                                std::cout << curDouble;
-                                counter++;
-                            }else{
-                                if(curDouble != NULL && counter < 4){
-                                    std::cout << ", " << curDouble;
-                                }
-                                counter++;
-                            }
+    // Quiet mode: std::cout turns every write into a no-op and printf output goes nowhere
+    if (quiet)
+    {
+        std::cout.setstate(std::ios::badbit);
+        if (freopen("/dev/null", "w", stdout) == NULL)
+        {
+            fprintf(stderr, "Error: cannot suppress output\n");
+            return 1;
+        }
+    }
 
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }
-                        std::cout << std::endl;
-                        break;
+    // Frame numbers are ints, so the frame count has to fit in one
+    if (page_size <= 0 || mem_size < (uint64_t)page_size || mem_size / page_size > 0x7FFFFFFF)
+    {
+        fprintf(stderr, "Error: memory size must hold between 1 and 2^31-1 pages\n");
+        return 1;
+    }
 
-                        case DataType::Long:
-                        for(int i = 0; i < curVar->size; i = i + elementSize) {
-                            long curLong;
-                            uint32_t elementSize = element_size(curVar->type);
-                            uint32_t physical_address = page_table->getPhysicalAddress(PID, curVar->virtual_address);
+    // Create physical 'memory'; the host only commits RAM for frames that get written
+    PhysicalMemory physical(mem_size, huge_pages);
+    if (!physical.isMapped())
+    {
+        fprintf(stderr, "Error: cannot map %llu bytes of physical memory\n", (unsigned long long)mem_size);
+        return 1;
+    }
+    void *memory = physical.getBase();
 
-                            memcpy(&curLong, (uint8_t*)memory + physical_address + i, elementSize);
+    // With demand paging, evicted pages go to a swap file, so variables can add up to memory plus swap
+    SwapFile *swap = NULL;
+    if (demand_paging)
+    {
+        if (swap_size == 0)
+        {
+            swap_size = 4 * mem_size;
+        }
+        if (swap_size / page_size > 0x7FFFFFFF)
+        {
+            fprintf(stderr, "Error: swap size must hold at most 2^31-1 pages\n");
+            return 1;
+        }
+        swap = new SwapFile(swap_path, (uint32_t)(swap_size / page_size), page_size);
+        if (!swap->isOpen())
+        {
+            fprintf(stderr, "Error: cannot create swap file '%s'\n", swap_path);
+            delete swap;
+            return 1;
+        }
+    }
 
-                            if(i == 0){
-                                std::cout << curLong;
-                                counter++;
-                            }else{
-                                if(curLong != NULL && counter < 4){
-                                    std::cout << ", " << curLong;
-                                }
-                                counter++;
-                            }
+    // Create MMU and Page Table
+    Mmu *mmu = new Mmu(demand_paging ? mem_size + swap_size : mem_size, page_size, alloc_policy);
+    PageTable *page_table = new PageTable(page_size, mem_size);
+    if (demand_paging)
+    {
+        page_table->enableDemandPaging(physical.getBase(), swap, createPageReplacer(replacement, page_table->getNumFrames()));
+    }
+    Tlb *tlb = NULL;
+    if (tlb_config.entries > 0)
+    {
+        tlb = new Tlb(tlb_config);
+        page_table->setTlb(tlb);
+    }
+    
+    // Everything a command needs, plus the tokenizer's scratch space
+    Simulator sim;
+    sim.mmu = mmu;
+    sim.page_table = page_table;
+    sim.tlb = tlb;
+    sim.memory = memory;
+    sim.physical = &physical;
+    sim.page_size = page_size;
+    sim.out = &std::cout;
+
+    if (load_path != NULL)
+    {
+        const char *error;
+        if (!loadCheckpoint(&sim, load_path, &error))
+        {
+            fprintf(stderr, "Error: cannot load checkpoint '%s': %s\n", load_path, error);
+            delete mmu;
+            delete page_table;
+            delete tlb;
+            delete swap;
+            return 1;
+        }
+    }
 
-                            
-                            if(counter == 4) {
-                                std::cout << ", ... [" << curVarElements << " items]";
-                                break;
-                            }
-                        }
-                        std::cout << std::endl;
-                        break;
+    // Parallel replay only works when nothing in the machine depends on how accesses from different processes interleave
+    ParallelReplay *replay = NULL;
+    if (batch_path != NULL && jobs > 1)
+    {
+        if (ParallelReplay::supports(&sim)) {
+            replay = new ParallelReplay(&sim, jobs);
+        } else {
+            fprintf(stderr, "Warning: --jobs needs a machine without --tlb or --demand-paging; replaying serially\n");
+        }
+    }
 
-                        default:
-                        break;
-                    }
-                    }
-                } catch(const std::invalid_argument& ia) {
-                    std::cout << "error: command not recognized" << std::endl;
-                }
-            }
-            
+    // Prompt loop
+    std::string command;
+    uint64_t commands_run = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
-        // Command not recognized
+    // Handle current command
+    while (readCommand(*input, command, batch_path == NULL)) {
+        // Skip blank lines and # comments in scripts
+        size_t first = command.find_first_not_of(' ');
+        if (first == std::string::npos || command[first] == '#') {
+            continue;
+        }
+        commands_run++;
+        if (replay != NULL) {
+            replay->submit(command);
         } else {
-            std::cout << "error: command not recognized" << std::endl;
+            executeCommand(&sim, command.data(), command.size());
         }
+    }
+    if (replay != NULL)
+    {
+        replay->finish();
+        delete replay;
+    }
 
-        // Get next command
-        std::cout << "> ";
-        std::getline (std::cin, command);
+    // Batch mode finishes with a throughput summary on stderr, so it shows up even with --quiet
+    if (batch_path != NULL)
+    {
+        std::cout.flush();
+        fflush(stdout);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fprintf(stderr, "%llu commands in %.3f s (%.0f commands/sec)\n", (unsigned long long)commands_run, seconds,
+            seconds > 0 ? commands_run / seconds : 0.0);
+    }
+
+    if (stats_path != NULL)
+    {
+        if (!statsEnabled()) {
+            fprintf(stderr, "Warning: statistics are compiled out; '%s' will only hold zeros\n", stats_path);
+        }
+        if (!writeStats(stats_path)) {
+            fprintf(stderr, "Error: cannot write statistics to '%s'\n", stats_path);
+        }
     }
 
     // Clean up
-    free(memory);
     delete mmu;
     delete page_table;
+    delete tlb;
+    delete swap;
 
     return 0;
 }
@@ -378,295 +306,81 @@ int main(int argc, char **argv)
 /** Prints start message and command list **/
 void printStartMessage(int page_size)
 {
-    std::cout << "Welcome to the Memory Allocation Simulator! Using a page size of " << page_size << " bytes." << std:: endl;
-    std::cout << "Commands:" << std:: endl;
-    std::cout << "  * create <text_size> <data_size> (initializes a new process)" << std:: endl;
-    std::cout << "  * allocate <PID> <var_name> <data_type> <number_of_elements> (allocated memory on the heap)" << std:: endl;
-    std::cout << "  * set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N> (set the value for a variable)" << std:: endl;
-    std::cout << "  * free <PID> <var_name> (deallocate memory on the heap that is associated with <var_name>)" << std:: endl;
-    std::cout << "  * terminate <PID> (kill the specified process)" << std:: endl;
-    std::cout << "  * print <object> (prints data)" << std:: endl;
-    std::cout << "    * If <object> is \"mmu\", print the MMU memory table" << std:: endl;
-    std::cout << "    * if <object> is \"page\", print the page table" << std:: endl;
-    std::cout << "    * if <object> is \"processes\", print a list of PIDs for processes that are still running" << std:: endl;
-    std::cout << "    * if <object> is a \"<PID>:<var_name>\", print the value of the variable for that process" << std:: endl;
-    std::cout << std::endl;
+    std::cout << "Welcome to the Memory Allocation Simulator! Using a page size of " << page_size << " bytes." << "\n";
+    std::cout << "Commands:" << "\n";
+    std::cout << "  * create <text_size> <data_size> (initializes a new process)" << "\n";
+    std::cout << "  * allocate <PID> <var_name> <data_type> <number_of_elements> (allocated memory on the heap)" << "\n";
+    std::cout << "  * set <PID> <var_name> <offset> <value_0> <value_1> <value_2> ... <value_N> (set the value for a variable)" << "\n";
+    std::cout << "  * free <PID> <var_name> (deallocate memory on the heap that is associated with <var_name>)" << "\n";
+    std::cout << "  * terminate <PID> (kill the specified process)" << "\n";
+    std::cout << "  * print <object> (prints data)" << "\n";
+    std::cout << "    * If <object> is \"mmu\", print the MMU memory table" << "\n";
+    std::cout << "    * if <object> is \"page\", print the page table" << "\n";
+    std::cout << "    * if <object> is \"processes\", print a list of PIDs for processes that are still running" << "\n";
+    std::cout << "    * if <object> is a \"<PID>:<var_name>\", print the value of the variable for that process" << "\n";
+    std::cout << "    * if <object> is \"memory\", print used and free bytes for the system and each process" << "\n";
+    std::cout << "    * if <object> is \"alloc\", print allocation latency and fragmentation" << "\n";
+    std::cout << "    * if <object> is \"tlb\", print TLB hit/miss statistics (requires --tlb <entries>)" << "\n";
+    std::cout << "    * if <object> is \"paging\", print page faults, evictions and write-backs (requires --demand-paging)" << "\n";
+    std::cout << "    * if <object> is \"stats\", print operation counts and latency histograms" << "\n";
+    std::cout << "  * dump <PID>:<var_name> [<start> [<count>]] (prints every element of a variable, or <count> elements from <start>)" << "\n";
+    std::cout << "  * save <file> (writes the whole machine to a checkpoint file)" << "\n";
+    std::cout << "  * load <file> (replaces the whole machine with one saved by \"save\")" << "\n";
+    std::cout << "\n";
 }
 
-/** Initializes a new process and prints its PID **/
-void createProcess(int text_size, int data_size, Mmu *mmu, PageTable *page_table)
+/** Parses a byte count with an optional K, M or G suffix (powers of 1024) **/
+bool parseMemorySize(const char *text, uint64_t *size)
 {
-    // Create a new process in the MMU using the MMU's createProcess() method, which returns the current PID
-    uint32_t current_pid = mmu->createProcess();
-    // Allocate <TEXT> variable for the newly created process using text_size
-    allocateVariable(current_pid, "<TEXT>", Char, text_size, mmu, page_table);
-    // Allocate <GLOBALS> variable for the newly created process using data_size
-    allocateVariable(current_pid, "<GLOBALS>", Char, data_size, mmu, page_table);
-    // Allocate <STACK> variable with a defined size of 65536
-    allocateVariable(current_pid, "<STACK>", Char, 65536, mmu, page_table);
-    // Print the current PID to the console
-    std::cout << current_pid << std::endl;
-}
-
-/** Allocates memory on the heap (how much depends on the data type and the number of elements), then prints the virtual memory address **/
-void allocateVariable(uint32_t pid, std::string var_name, DataType type, uint32_t num_elements, Mmu *mmu, PageTable *page_table)
-{
-    uint32_t theNewVariableSize;
-    int elementSize;
-
-    theNewVariableSize = element_size(type) * num_elements;
-    elementSize = element_size(type);
-
-    if(mmu->findVariable(pid, var_name)){
-        std::cout << "error: variable already exists" << std::endl;
-        return;
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text)
+    {
+        return false;
     }
-
-    if(mmu->checkTotalSpace(theNewVariableSize) == true){
-
-        std::vector<Variable*> variables = mmu->getVariables(pid);
-        for(int i=0; i < variables.size(); i++){
-            //Look for free space and check if there is enough space for the new elements
-            if(variables[i]->name == "<FREE_SPACE>" && variables[i]->size >= theNewVariableSize){
-                uint32_t addressOfFreeSpace = variables[i]->virtual_address;
-                uint32_t sizeOfFreeSpace = variables[i]->size;
-                int pageNumber = page_table->getPageNumber(addressOfFreeSpace);
-                uint32_t spaceLeftOnpage = mmu->getFreeSpaceLeftOnPage(pid, pageNumber, page_table->getPageSize(), addressOfFreeSpace);
-
-                Variable *newVariable = variables[i];
-                //check if the page fits the new variable
-                if(spaceLeftOnpage >= theNewVariableSize){
-                    variables[i]->size = sizeOfFreeSpace - theNewVariableSize;
-                    
-                    mmu->addVariableToProcess(pid, var_name, type, theNewVariableSize, newVariable->virtual_address);
-                    pageNumber = page_table->getPageNumber(newVariable->virtual_address);
-                    variables[i]->virtual_address = variables[i]->virtual_address + theNewVariableSize;
-                    uint32_t tempAddress = addressOfFreeSpace + theNewVariableSize - 1;
-                    int endOfVariablePage = page_table->getPageNumber(tempAddress);
-
-                    int i = pageNumber;
-                    while (i <= endOfVariablePage){
-                        page_table->addEntry(pid,i);
-                        i++;
-                    }
-                    
-                    if(var_name != "<TEXT>" && var_name != "<GLOBALS>" && var_name != "<STACK>"){
-                            std::cout << addressOfFreeSpace << std::endl;
-                    }
-                    break;
-                }else if(spaceLeftOnpage >= elementSize){
-
-                    while(spaceLeftOnpage%elementSize != 0){
-                        addressOfFreeSpace++;
-                    }
-                        
-                    if(sizeOfFreeSpace >= theNewVariableSize){
-                        variables[i]->size = sizeOfFreeSpace - theNewVariableSize;
-                        mmu->addVariableToProcess(pid, var_name, type, theNewVariableSize, newVariable->virtual_address);
-                        pageNumber = page_table->getPageNumber(newVariable->virtual_address);
-                        variables[i]->virtual_address = addressOfFreeSpace + theNewVariableSize;
-
-                        uint32_t tempAddress = addressOfFreeSpace + theNewVariableSize - 1;
-                        int endOfVariablePage = page_table->getPageNumber(tempAddress);
-
-                        
-                        int i = pageNumber;
-                        while (i <= endOfVariablePage){
-                            page_table->addEntry(pid,i);
-                            i++;
-                        }
-                        
-                        if(var_name != "<TEXT>" && var_name != "<GLOBALS>" && var_name != "<STACK>"){
-                            std::cout << addressOfFreeSpace << std::endl;
-                        }
-                            
-                        break;
-                    }else{
-                            //the variables size is bigger than the new size of the free space
-                        mmu->addVariableToProcess(pid, var_name, type, theNewVariableSize, addressOfFreeSpace);
-
-                    }
-                }else if(spaceLeftOnpage < elementSize){
-                    while(page_table->getPageNumber(addressOfFreeSpace) == pageNumber){
-                        addressOfFreeSpace++;
-                    }
-                    if(sizeOfFreeSpace >= theNewVariableSize){
-                        variables[i]->size = sizeOfFreeSpace - theNewVariableSize;
-                        mmu->addVariableToProcess(pid, var_name, type, theNewVariableSize, newVariable->virtual_address);
-                        pageNumber = page_table->getPageNumber(newVariable->virtual_address);
-                        variables[i]->virtual_address = addressOfFreeSpace + theNewVariableSize;
-
-                        uint32_t tempAddress = addressOfFreeSpace + theNewVariableSize - 1;
-                        int endOfVariablePage = page_table->getPageNumber(tempAddress);
-
-
-            
-                        int i = pageNumber;
-                        while (i <= endOfVariablePage){
-                            page_table->addEntry(pid,i);
-                            i++;
-                        }
-                
-                        if(var_name != "<TEXT>" && var_name != "<GLOBALS>" && var_name != "<STACK>"){
-                            std::cout << addressOfFreeSpace << std::endl;
-                        }
-                        break;
-                    }else{
-                            //the variables size is bigger than the new size of the free space
-                        mmu->addVariableToProcess(pid, var_name, type, theNewVariableSize, addressOfFreeSpace);
-                    }
-                }
-            }
-        }//end of for loop
-    }else{
-        std::cout << "error: allocation would exceed system memory" << std::endl;
+    switch (*end) {
+        case 'K': case 'k': value <<= 10; end++; break;
+        case 'M': case 'm': value <<= 20; end++; break;
+        case 'G': case 'g': value <<= 30; end++; break;
+        default: break;
     }
-    
-
-    
-}
-
-/** Sets the value for a variable starting at an offset **/
-void setVariable(uint32_t pid, std::string var_name, uint32_t offset, void *value, Mmu *mmu, PageTable *page_table, void *memory)
-{
-    
-
-    Variable* current_var = mmu->getVariable(pid, var_name);
-    int physical_address = page_table->getPhysicalAddress(pid, current_var->virtual_address+offset);
-    uint32_t elementSize = element_size(current_var->type);
-    memcpy((uint8_t*)memory + physical_address, value, elementSize);
+    if (*end != '\0' || value == 0)
+    {
+        return false;
+    }
+    *size = value;
+    return true;
 }
 
-/** Deallocates memory on the heap that is associated with a variable **/
-void freeVariable(uint32_t pid, std::string var_name, Mmu *mmu, PageTable *page_table)
+/** Parses a decimal count that must lie in [min, max] **/
+bool parseCount(const char *text, long min, long max, uint32_t *count)
 {
-    // Check if the pid exists, if not, print an error and do nothing
-    // Remove entry from MMU by by changing the variable name and type to represent free space (using set()?)
-
-    if(!mmu->findProcess(pid)) {
-        std::cout << "error: process not found" << std::endl;
-        return;
-    }
-
-    // Check if variable exists, if not, print and error and do nothing
-    if(!mmu->findVariable(pid, var_name)) {
-        std::cout << "error: variable not found" << std::endl;
-        return;
-    }
-
-    Variable* curVar = mmu->getVariable(pid, var_name);
-    std::vector<Variable*> allVariable = mmu->getVariables(pid);
-    int page = page_table->getPageNumber(curVar->virtual_address);
-    int endVarpage = page_table->getPageNumber(curVar->virtual_address + curVar->size - 1);
-    int num_pages = endVarpage - page + 1;
-
-    //we check if other var are on the same starting page
-    //we check the same page until we get to the ending page
-
-    for(int i=page; i <= endVarpage; i++){
-        bool check = true;
-        for(int j=0; j < allVariable.size(); j++){
-            if(page_table->getPageNumber(allVariable[j]->virtual_address) == i
-            && allVariable[j]->name != "<FREE_SPACE>"){
-                check = false;
-            }
-        }
-        if(check == true){
-            page_table->freeSinglePage(pid, i);
-        }
+    char *end;
+    errno = 0;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || errno == ERANGE || value < min || value > max)
+    {
+        return false;
     }
-
-
-    mmu->freeVariable(pid, curVar);
-    
-
-    
+    *count = (uint32_t)value;
+    return true;
 }
 
-/** Kills the specified process and frees all memory associated with it **/
-void terminateProcess(uint32_t pid, Mmu *mmu, PageTable *page_table)
+/** Reads the next command, prompting first in interactive mode; returns false on "exit" or end of input **/
+bool readCommand(std::istream &input, std::string &command, bool prompt)
 {
-    // If the process does not exist, display a message and do nothing
-    if(mmu->findProcess(pid) == false) {
-        std::cout << "error: process not found" << std::endl;
-        return;
+    if (prompt)
+    {
+        std::cout << "> " << std::flush;
     }
-    // Otherwise, remove the process from MMU
-    mmu->removeProcess(pid);
-    // Also free all pages associated with given process
-    page_table->freeAllPagesOfProcess(pid);
-}
-
-/** splitString function imported from assignment 2 - splits a string based on a delimiter and stores the result in a vector **/
-void splitString(std::string text, char d, std::vector<std::string>& result)
-{   
-    enum states { NONE, IN_WORD, IN_STRING } state = NONE;
-    int i;
-    std::string token;
-    result.clear();
-    for (i = 0; i < text.length(); i++)
+    if (!std::getline(input, command))
     {
-        char c = text[i];
-        switch (state) {
-            case NONE:
-                if (c != d)
-                {
-                    if (c == '\"')
-                    {
-                        state = IN_STRING;
-                        token = "";
-                    }
-                    else
-                    {
-                        state = IN_WORD;
-                        token = c;
-                    }
-                }
-                break;
-            case IN_WORD:
-                if (c == d)
-                {
-                    result.push_back(token);
-                    state = NONE;
-                }
-                else
-                {
-                    token += c;
-                }
-                break;
-            case IN_STRING:
-                if (c == '\"')
-                {
-                    result.push_back(token);
-                    state = NONE;
-                }
-                else
-                {
-                    token += c;
-                }
-                break;
-        }
+        return false;
     }
-    if (state != NONE)
+    // Scripts written on Windows end their lines with \r\n
+    if (!command.empty() && command[command.size() - 1] == '\r')
     {
-        result.push_back(token);
+        command.erase(command.size() - 1);
     }
+    return command != "exit";
 }
-
-int element_size(DataType type){
-    int elementSize = 0;
-    if(type == DataType::Char){
-        elementSize = 1;
-    }else if(type == DataType::Short){
-        elementSize = 2;
-    }else if(type == DataType::Int){
-        elementSize = 4;
-    }else if(type == DataType::Float){
-        elementSize = 4;
-    }else if(type == DataType::Double){
-        elementSize = 8;
-    }else if(type == DataType::Long){
-        elementSize = 8;
-    }
-    return elementSize;
-}
\ No newline at end of file
@@ -1,295 +1,527 @@
 #include "mmu.h"
+#include "stats.h"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <chrono>
 
-Mmu::Mmu(int memory_size)
+Mmu::Mmu(uint64_t memory_size, int page_size, AllocationPolicy policy) : _process_slabs(16384), _variable_slabs(16384), _process_pool(&_process_slabs)
 {
-    _next_pid = 1024;
+    _first_pid = 1024;
+    _next_pid = _first_pid;
     _max_size = memory_size;
+    // Virtual addresses are 32 bits wide, so on machines of 4 GB or more a process stops at the last whole page below 4 GB
+    _process_size = (memory_size < 0x100000000ULL) ? (uint32_t)memory_size : (uint32_t)((0x100000000ULL - page_size) / page_size * page_size);
+    _page_size = page_size;
+    _num_processes = 0;
+    _used_bytes.store(0);
+    _reserved_bytes.store(0);
+    _policy = policy;
+    _alloc_stats = AllocatorStats();
 }
 
 Mmu::~Mmu()
 {
+    for (size_t i = 0; i < _processes.size(); i++)
+    {
+        if (_processes[i] != NULL)
+        {
+            _processes[i]->variable_pool.releaseAll();
+            delete _processes[i]->heap;
+            _process_pool.destroy(_processes[i]);
+        }
+    }
 }
 
 uint32_t Mmu::createProcess()
 {
-    Process *proc = new Process();
+    std::lock_guard<std::mutex> guard(_table_lock);
+    Process *proc = _process_pool.create();
     proc->pid = _next_pid;
+    proc->variable_pool.setCache(&_variable_slabs);
+    proc->used_bytes = 0;
+    proc->reserved_bytes = 0;
 
-    Variable *var = new Variable();
-    var->name = "<FREE_SPACE>";
-    var->type = DataType::FreeSpace;
-    var->virtual_address = 0;
-    var->size = _max_size;
-    proc->variables.push_back(var);
+    // The whole virtual address space starts out free, managed by the allocator picked at startup
+    proc->heap = createHeapAllocator(_policy, _process_size);
 
+    // PIDs are handed out in increasing order, so the new process always goes in the next slot
     _processes.push_back(proc);
+    _num_processes++;
 
     _next_pid++;
     return proc->pid;
 }
 
-void Mmu::addVariableToProcess(uint32_t pid, std::string var_name, DataType type, uint32_t size, uint32_t address)
+/** PID the next createProcess() will hand out; PIDs are never reused, so a replay can work out ahead of time which PID each create gets **/
+uint32_t Mmu::getNextPid()
 {
-    int i;
-    Process *proc = NULL;
-    for (i = 0; i < _processes.size(); i++)
+    std::lock_guard<std::mutex> guard(_table_lock);
+    return _next_pid;
+}
+
+/** Looks up a process by PID in constant time, returns NULL if it does not exist **/
+Process* Mmu::getProcess(uint32_t pid)
+{
+    STAT_SCOPE(StatLookup);
+    std::lock_guard<std::mutex> guard(_table_lock);
+    return findProcessLocked(pid);
+}
+
+/** getProcess() for callers already holding _table_lock **/
+Process* Mmu::findProcessLocked(uint32_t pid)
+{
+    if (pid < _first_pid || pid - _first_pid >= _processes.size())
     {
-        if (_processes[i]->pid == pid)
-        {
-            proc = _processes[i];
-        }
+        return NULL;
+    }
+    return _processes[pid - _first_pid];
+}
+
+void Mmu::addVariableToProcess(uint32_t pid, const std::string &var_name, DataType type, uint32_t size, uint32_t address)
+{
+    addVariableToProcess(getProcess(pid), var_name, type, size, address);
+}
+
+void Mmu::addVariableToProcess(Process *proc, const std::string &var_name, DataType type, uint32_t size, uint32_t address)
+{
+    if (proc == NULL)
+    {
+        return;
     }
 
-    Variable *var = new Variable();
-    var->name = var_name;
+    std::lock_guard<std::mutex> guard(proc->lock);
+    _used_bytes += size;
+    insertVariable(proc, var_name, type, size, address);
+}
+
+/** Records a variable in its process; the caller holds the process lock and has already counted its bytes system-wide **/
+void Mmu::insertVariable(Process *proc, const std::string &var_name, DataType type, uint32_t size, uint32_t address)
+{
+    Variable *var = proc->variable_pool.create();
+    {
+        std::lock_guard<std::mutex> guard(_names_lock);
+        var->name = _names.intern(var_name);
+    }
     var->type = type;
     var->virtual_address = address;
     var->size = size;
-    if (proc != NULL)
+    proc->variables[address] = var;
+    proc->names[var->name] = var;
+
+    proc->used_bytes += size;
+
+    // Count the variable's bytes against every page it touches
+    if (size > 0)
     {
-        proc->variables.push_back(var);
+        uint32_t first_page = address / _page_size;
+        uint32_t last_page = (address + size - 1) / _page_size;
+        for (uint32_t page = first_page; page <= last_page; page++)
+        {
+            uint32_t page_start = page * _page_size;
+            uint32_t start = std::max(address, page_start);
+            uint32_t end = std::min(address + size, page_start + _page_size);
+            PageUsage &usage = proc->pages[page];
+            usage.live_bytes += end - start;
+            usage.live_variables++;
+        }
     }
 }
 
+/** Reserves space for a new variable with the process's allocator and adds it; returns NULL if it doesn't fit **/
+Variable* Mmu::allocateVariable(Process *proc, const std::string &var_name, DataType type, uint32_t size)
+{
+    // Claim the bytes system-wide first, so threads allocating at the same time can't overshoot memory together
+    if (proc == NULL || !reserveSpace(size))
+    {
+        return NULL;
+    }
+
+    std::lock_guard<std::mutex> guard(proc->lock);
+    uint32_t address;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool fits = proc->heap->allocate(size, &address);
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    {
+        std::lock_guard<std::mutex> stats_guard(_stats_lock);
+        _alloc_stats.allocate_ns += ns;
+        if (ns > _alloc_stats.max_allocate_ns) { _alloc_stats.max_allocate_ns = ns; }
+        if (fits) { _alloc_stats.allocations++; } else { _alloc_stats.failures++; }
+    }
+    STAT_RECORD(StatAllocate, ns);
+    if (!fits)
+    {
+        _used_bytes -= size;
+        return NULL;
+    }
+
+    uint32_t reserved = proc->heap->reservedSize(size);
+    proc->reserved_bytes += reserved;
+    _reserved_bytes += reserved;
+
+    insertVariable(proc, var_name, type, size, address);
+    return proc->variables[address];
+}
+
+/** Adds size bytes to the system-wide total if they fit, in one atomic step **/
+bool Mmu::reserveSpace(uint32_t size)
+{
+    uint64_t used = _used_bytes.load();
+    do
+    {
+        if (used + size > _max_size)
+        {
+            return false;
+        }
+    } while (!_used_bytes.compare_exchange_weak(used, used + size));
+    return true;
+}
+
 void Mmu::print()
 {
-    int i, j;
+    int i;
+    std::lock_guard<std::mutex> guard(_table_lock);
 
-    std::cout << " PID  | Variable Name | Virtual Addr | Size" << std::endl;
-    std::cout << "------+---------------+--------------+------------" << std::endl;
+    std::cout << " PID  | Variable Name | Virtual Addr | Size" << "\n";
+    std::cout << "------+---------------+--------------+------------" << "\n";
 
     // For all processess...
     for (i = 0; i < _processes.size(); i++)
     {
-        // For each variable associated with the current process...
-        for (j = 0; j < _processes[i]->variables.size(); j++)
+        Process *proc = _processes[i];
+        if (proc == NULL)
         {
-            // If the current variable is not a <FREE_SPACE> entry...
-            if(_processes[i]->variables[j]->name != "<FREE_SPACE>") 
-            {
-                std::stringstream ss;
-                ss << "  0x" << std::setfill('0') << std::setw(8) << std::uppercase << std::hex << _processes[i]->variables[j]->virtual_address;
-                std::string hex_virtual_address(ss.str());
-
-                printf("%5u | %-13.13s | %s | %10u\n", _processes[i]->pid, _processes[i]->variables[j]->name.c_str(),
-                hex_virtual_address.c_str(), _processes[i]->variables[j]->size);
-            }
+            continue;
         }
-    }
-}
+        std::lock_guard<std::mutex> proc_guard(proc->lock);
 
-bool Mmu::removeProcess(uint32_t pid) {
-    for(int i=0; i < _processes.size(); i++){
-        if(_processes[i]->pid == pid) {
-            _processes.erase(_processes.begin() + i);
-            return true;
+        // For each variable associated with the current process, in address order...
+        std::map<uint32_t, Variable*>::iterator it;
+        for (it = proc->variables.begin(); it != proc->variables.end(); ++it)
+        {
+            Variable *var = it->second;
+            std::stringstream ss;
+            ss << "  0x" << std::setfill('0') << std::setw(8) << std::uppercase << std::hex << var->virtual_address;
+            std::string hex_virtual_address(ss.str());
+
+            printf("%5u | %-13.13s | %s | %10u\n", proc->pid, getVariableName(var).c_str(),
+            hex_virtual_address.c_str(), var->size);
         }
     }
-    return false;
 }
 
-bool Mmu::findProcess(uint32_t pid){
-    for(int i=0; i < _processes.size(); i++){
-        if(_processes[i]->pid == pid){
-            return true;
-        }
+bool Mmu::removeProcess(uint32_t pid) {
+    std::lock_guard<std::mutex> guard(_table_lock);
+    Process *proc = findProcessLocked(pid);
+    if (proc == NULL) {
+        return false;
     }
-    return false;
-}
+    _processes[pid - _first_pid] = NULL;
+    _num_processes--;
 
-//This function check the total space left on the process before adding new variable
-bool Mmu::checkTotalSpace(uint32_t newVariableSize){
-    //uint32_t mem_size = 67108864;
-    uint32_t mem_size = _max_size;
-    uint32_t totalSpaceUsed = newVariableSize;
-        // For all processess...
-    for (int i = 0; i < _processes.size(); i++)
+    // Wait out anything (a print, say) still looking at the process before tearing it down
     {
-        // For each variable associated with the current process...
-        for (int j = 0; j < _processes[i]->variables.size(); j++)
+        std::lock_guard<std::mutex> proc_guard(proc->lock);
+        _used_bytes -= proc->used_bytes;
+        _reserved_bytes -= proc->reserved_bytes;
+
+        // Variables are plain records, so their slabs go straight back to the cache without visiting each one;
+        // only their names need handing back
         {
-            if(_processes[i]->variables[j]->name != "<FREE_SPACE>") 
+            std::lock_guard<std::mutex> names_guard(_names_lock);
+            std::unordered_map<uint32_t, Variable*>::iterator it;
+            for (it = proc->names.begin(); it != proc->names.end(); ++it)
             {
-               totalSpaceUsed = totalSpaceUsed + _processes[i]->variables[j]->size;
+                _names.release(it->first);
             }
         }
+        proc->variable_pool.releaseAll();
+        delete proc->heap;
     }
-    if(totalSpaceUsed > mem_size){
-        return false;
-    }else{
-        return true;
+    _process_pool.destroy(proc);
+
+    // Drop terminated slots from the front of the table so it doesn't grow with every process ever created
+    while (!_processes.empty() && _processes.front() == NULL)
+    {
+        _processes.pop_front();
+        _first_pid++;
     }
+    return true;
 }
 
-void Mmu::printProcesses(){
-    for(int i=0; i < _processes.size(); i++){
-        std::cout << _processes[i]->pid << std::endl;
+bool Mmu::findProcess(uint32_t pid){
+    return getProcess(pid) != NULL;
+}
+
+//This function check the total space left on the system before adding new variable
+bool Mmu::checkTotalSpace(uint32_t newVariableSize){
+    // The running total is kept up to date by allocate, free and terminate
+    return _used_bytes.load() + newVariableSize <= _max_size;
+}
+
+uint64_t Mmu::getUsedBytes(){ return _used_bytes; }
+
+uint64_t Mmu::getFreeBytes(){ return _max_size - _used_bytes; }
+
+uint32_t Mmu::getProcessUsedBytes(uint32_t pid){
+    Process *proc = getProcess(pid);
+    if(proc == NULL){
+        return 0;
     }
+    std::lock_guard<std::mutex> guard(proc->lock);
+    return proc->used_bytes;
 }
 
-std::vector<Variable*> Mmu::getVariables(uint32_t pid){
-    std::vector<Variable*> empty;
-    if(findProcess(pid)){
-        for(int i=0; i < _processes.size(); i++){
-            if(_processes[i]->pid == pid){
-                return _processes[i]->variables;
-            }
-        }
-    }else{
-        return empty;
+uint32_t Mmu::getProcessFreeBytes(uint32_t pid){
+    Process *proc = getProcess(pid);
+    if(proc == NULL){
+        return 0;
     }
-    return empty;
-}
-
-bool Mmu::findVariable(uint32_t pid, std::string var_name) {
-    if(findProcess(pid)){
-        for(int i=0; i < _processes.size(); i++){
-            if(_processes[i]->pid == pid) {
-                int j;
-                for(j = 0; j < _processes[i]->variables.size(); j++) { 
-                    if(_processes[i]->variables[j]->name == var_name) {
-                        return true;
-                    }
-                }
-                return false;
-            }
+    std::lock_guard<std::mutex> guard(proc->lock);
+    return _process_size - proc->used_bytes;
+}
+
+/** Prints used and free bytes for the whole system and for each running process **/
+void Mmu::printMemoryUsage(){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    printf("System: %llu bytes used, %llu bytes free (%u processes)\n", (unsigned long long)_used_bytes.load(),
+        (unsigned long long)getFreeBytes(), _num_processes);
+
+    std::cout << " PID  | Used Bytes | Free Bytes" << "\n";
+    std::cout << "------+------------+------------" << "\n";
+    for(int i=0; i < _processes.size(); i++){
+        if(_processes[i] != NULL){
+            std::lock_guard<std::mutex> proc_guard(_processes[i]->lock);
+            printf("%5u | %10u | %10u\n", _processes[i]->pid, _processes[i]->used_bytes, _process_size - _processes[i]->used_bytes);
         }
-        return false;
-    }else{
-        return false;
     }
 }
 
-Variable* Mmu::getVariable(uint32_t pid, std::string var_name) {
-    Variable* empty = NULL;
-    if(findProcess(pid)){
-        for(int i=0; i < _processes.size(); i++){
-            if(_processes[i]->pid == pid) {
-                int j;
-                for(j = 0; j < _processes[i]->variables.size(); j++) { 
-                    if(_processes[i]->variables[j]->name == var_name) {
-                        return _processes[i]->variables[j];
-                    }
-                }
-                return empty;
-            }
+void Mmu::printProcesses(){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    for(int i=0; i < _processes.size(); i++){
+        if(_processes[i] != NULL){
+            std::cout << _processes[i]->pid << "\n";
         }
-        return empty;
-    }else{
-        return empty;
     }
 }
 
-void Mmu::freeVariable(uint32_t pid, Variable* curVar){
-
-    std::vector<Variable*> allVariables = getVariables(pid);
-    int indexOfCurVar = getVariableWithaddress(pid, curVar->virtual_address);
-    int indexOfNextVariable = getVariableWithaddress(pid, curVar->virtual_address + curVar->size);
-
-    uint32_t tempAddress = curVar->virtual_address-1;
-
-    int indexOfprev = -1;
-
-    while(indexOfprev != 0){
-            if(getVariableWithaddress(pid, tempAddress) != -1){
-                indexOfprev = getVariableWithaddress(pid, tempAddress);
-                break;
-            }
-        tempAddress--;
+std::vector<Variable*> Mmu::getVariables(uint32_t pid){
+    std::vector<Variable*> variables;
+    Process *proc = getProcess(pid);
+    if(proc != NULL){
+        std::lock_guard<std::mutex> guard(proc->lock);
+        std::map<uint32_t, Variable*>::iterator it;
+        for (it = proc->variables.begin(); it != proc->variables.end(); ++it){
+            variables.push_back(it->second);
+        }
     }
+    return variables;
+}
 
-    
-    for(int i=0; i < _processes.size(); i++){
+bool Mmu::findVariable(uint32_t pid, const std::string &var_name) {
+    return getVariable(pid, var_name) != NULL;
+}
 
-        if(_processes[i]->pid == pid) {
-            // Check if either the variable just before it and/or just after it are also free space - if so merge them into one larger free space
+Variable* Mmu::getVariable(uint32_t pid, const std::string &var_name) {
+    return getVariable(getProcess(pid), var_name);
+}
 
+Variable* Mmu::getVariable(Process *proc, const std::string &var_name) {
+    if(proc == NULL){
+        return NULL;
+    }
+    // A name no live variable uses can't belong to this process. The id is looked up with the process locked: a
+    // variable of this process holds a reference to its name, so the id can't be dropped and reused in between
+    std::lock_guard<std::mutex> guard(proc->lock);
+    uint32_t id;
+    {
+        std::lock_guard<std::mutex> names_guard(_names_lock);
+        id = _names.find(var_name);
+    }
+    if(id == NameTable::NOT_FOUND){
+        return NULL;
+    }
+    std::unordered_map<uint32_t, Variable*>::iterator it = proc->names.find(id);
+    return (it != proc->names.end()) ? it->second : NULL;
+}
 
-            if(_processes[i]->variables[indexOfNextVariable]->name == "<FREE_SPACE>" && _processes[i]->variables[indexOfprev]->name == "<FREE_SPACE>"){
-                _processes[i]->variables[indexOfNextVariable]->virtual_address = _processes[i]->variables[indexOfprev]->virtual_address;
-                _processes[i]->variables[indexOfNextVariable]->size = _processes[i]->variables[indexOfNextVariable]->size + _processes[i]->variables[indexOfCurVar]->size;
-                _processes[i]->variables[indexOfNextVariable]->size = _processes[i]->variables[indexOfNextVariable]->size  + _processes[i]->variables[indexOfprev]->size;
-                _processes[i]->variables.erase(_processes[i]->variables.begin() + indexOfCurVar);
-                _processes[i]->variables.erase(_processes[i]->variables.begin() + indexOfprev);
-            }else{
-                if(_processes[i]->variables[indexOfNextVariable]->name == "<FREE_SPACE>"){
-                    _processes[i]->variables[indexOfNextVariable]->virtual_address = _processes[i]->variables[indexOfCurVar]->virtual_address;
+const std::string& Mmu::getVariableName(Variable *var) {
+    // The string never moves while interned, so the reference stays good for as long as the variable lives
+    std::lock_guard<std::mutex> guard(_names_lock);
+    return _names.getName(var->name);
+}
 
-                    _processes[i]->variables[indexOfNextVariable]->size = _processes[i]->variables[indexOfNextVariable]->size
-                    + _processes[i]->variables[indexOfCurVar]->size;
+void Mmu::freeVariable(uint32_t pid, Variable* curVar, std::vector<int> *released_pages){
+    freeVariable(getProcess(pid), curVar, released_pages);
+}
 
-                    _processes[i]->variables.erase(_processes[i]->variables.begin() + indexOfCurVar);
+/** Frees a variable; pages left with no live variables are appended to released_pages (if not NULL) **/
+void Mmu::freeVariable(Process *proc, Variable* curVar, std::vector<int> *released_pages){
+    if(proc == NULL){
+        return;
+    }
+    std::lock_guard<std::mutex> guard(proc->lock);
+
+    // Only the pages this variable touches need their counts updated
+    if(curVar->size > 0){
+        uint32_t first_page = curVar->virtual_address / _page_size;
+        uint32_t last_page = (curVar->virtual_address + curVar->size - 1) / _page_size;
+        for(uint32_t page = first_page; page <= last_page; page++){
+            uint32_t page_start = page * _page_size;
+            uint32_t start = std::max(curVar->virtual_address, page_start);
+            uint32_t end = std::min(curVar->virtual_address + curVar->size, page_start + _page_size);
+            std::unordered_map<uint32_t, PageUsage>::iterator usage = proc->pages.find(page);
+            usage->second.live_bytes -= end - start;
+            usage->second.live_variables--;
+            if(usage->second.live_variables == 0){
+                proc->pages.erase(usage);
+                if(released_pages != NULL){
+                    released_pages->push_back(page);
                 }
+            }
+        }
+    }
 
+    // The variable stops being reachable by name or address as soon as it's freed
+    proc->names.erase(curVar->name);
+    {
+        std::lock_guard<std::mutex> names_guard(_names_lock);
+        _names.release(curVar->name);
+    }
+    proc->variables.erase(curVar->virtual_address);
+    proc->used_bytes -= curVar->size;
+    _used_bytes -= curVar->size;
+
+    // Give its bytes back to the allocator, which merges them with free neighbours as its policy dictates
+    uint32_t reserved = proc->heap->reservedSize(curVar->size);
+    proc->reserved_bytes -= reserved;
+    _reserved_bytes -= reserved;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    proc->heap->release(curVar->virtual_address, curVar->size);
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    {
+        std::lock_guard<std::mutex> stats_guard(_stats_lock);
+        _alloc_stats.release_ns += ns;
+        _alloc_stats.releases++;
+    }
+    STAT_RECORD(StatFree, ns);
 
-                if(_processes[i]->variables[indexOfprev]->name == "<FREE_SPACE>"){
-                    _processes[i]->variables[indexOfprev]->size = _processes[i]->variables[indexOfprev]->size
-                    + _processes[i]->variables[indexOfCurVar]->size;
-                    _processes[i]->variables.erase(_processes[i]->variables.begin() + indexOfCurVar);
-                }
+    proc->variable_pool.destroy(curVar);
+}
 
+Variable* Mmu::getVariableWithaddress(uint32_t pid, uint32_t address){
+    return getVariableWithaddress(getProcess(pid), address);
+}
 
-                if(_processes[i]->variables[indexOfNextVariable]->name != "<FREE_SPACE>" && 
-                    _processes[i]->variables[indexOfprev]->name != "<FREE_SPACE>"){
-                    _processes[i]->variables[indexOfCurVar]->name = "<FREE_SPACE>";
-                    _processes[i]->variables[indexOfCurVar]->type = DataType::FreeSpace;
+Variable* Mmu::getVariableWithaddress(Process *proc, uint32_t address){
+    if(proc == NULL){
+        return NULL;
+    }
+    std::lock_guard<std::mutex> guard(proc->lock);
+    std::map<uint32_t, Variable*>::iterator it = proc->variables.find(address);
+    return (it != proc->variables.end()) ? it->second : NULL;
+}
 
-                }
-            }
+/** Bytes on a page not yet taken by any of the process's variables **/
+int Mmu::getFreeSpaceLeftOnPage(uint32_t pid, int page_number){
+    Process *proc = getProcess(pid);
+    if(proc == NULL){
+        return 0;
+    }
+    std::lock_guard<std::mutex> guard(proc->lock);
+    std::unordered_map<uint32_t, PageUsage>::iterator usage = proc->pages.find(page_number);
+    return (usage != proc->pages.end()) ? _page_size - usage->second.live_bytes : _page_size;
+}
 
+AllocationPolicy Mmu::getAllocationPolicy(){ return _policy; }
 
-            
-            
+/** Prints allocation latency and the fragmentation the allocation policy has left behind **/
+void Mmu::printAllocatorStats(){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    uint64_t free_bytes = 0;
+    uint64_t largest_sum = 0;
+    uint64_t free_blocks = 0;
+    double worst = 0.0;
+    for(int i=0; i < _processes.size(); i++){
+        if(_processes[i] != NULL){
+            std::lock_guard<std::mutex> proc_guard(_processes[i]->lock);
+            HeapAllocator *heap = _processes[i]->heap;
+            free_bytes += heap->getFreeBytes();
+            largest_sum += heap->getLargestFreeBlock();
+            free_blocks += heap->getNumFreeBlocks();
+            if(heap->getFragmentation() > worst){ worst = heap->getFragmentation(); }
         }
     }
 
-
+    std::lock_guard<std::mutex> stats_guard(_stats_lock);
+    uint64_t attempts = _alloc_stats.allocations + _alloc_stats.failures;
+    printf("Allocator: %s\n", allocationPolicyName(_policy));
+    printf("  allocations:            %llu (%llu failed)\n", (unsigned long long)_alloc_stats.allocations, (unsigned long long)_alloc_stats.failures);
+    printf("  releases:               %llu\n", (unsigned long long)_alloc_stats.releases);
+    printf("  avg allocate latency:   %.1f ns (max %llu ns)\n", attempts > 0 ? (double)_alloc_stats.allocate_ns / attempts : 0.0,
+        (unsigned long long)_alloc_stats.max_allocate_ns);
+    printf("  avg release latency:    %.1f ns\n", _alloc_stats.releases > 0 ? (double)_alloc_stats.release_ns / _alloc_stats.releases : 0.0);
+    printf("  free blocks:            %llu\n", (unsigned long long)free_blocks);
+    printf("  external fragmentation: %.2f%% (worst process %.2f%%)\n",
+        free_bytes > 0 ? 100.0 * (1.0 - (double)largest_sum / free_bytes) : 0.0, 100.0 * worst);
+    printf("  internal fragmentation: %llu bytes\n", (unsigned long long)(_reserved_bytes.load() - _used_bytes.load()));
 }
 
-int Mmu::getVariableWithaddress(uint32_t pid, uint32_t address){
-    if(findProcess(pid)){
-        for(int i=0; i < _processes.size(); i++){
-            if(_processes[i]->pid == pid) {
-                int j;
-                for(j = 0; j < _processes[i]->variables.size(); j++) { 
-                    if(_processes[i]->variables[j]->virtual_address == address) {
-                        return j;
-                    }
-                }
-                return -1;
-            }
-        }
-        return -1;
-    }else{
-        return -1;
-    }   
-}
-
-int Mmu::getFreeSpaceLeftOnPage(uint32_t pid, int page_number, int page_size, uint32_t address){
-    int spaceLeft = page_size;
-    if(findProcess(pid)){
-        for(int i=0; i < _processes.size(); i++){
-            if(_processes[i]->pid == pid){
-                for(int j=0; j<_processes[i]->variables.size(); j++){
-                    int variable_pageNumber = _processes[i]->variables[j]->virtual_address / page_size;
-                    if(_processes[i]->variables[j]->name != "<FREE_SPACE>" && variable_pageNumber == page_number){
-                        spaceLeft = spaceLeft - _processes[i]->variables[j]->size;
-                    }
-                }
-            }
+/** PIDs of every running process, in increasing order **/
+std::vector<uint32_t> Mmu::getPids(){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    std::vector<uint32_t> pids;
+    for(size_t i=0; i < _processes.size(); i++){
+        if(_processes[i] != NULL){
+            pids.push_back(_processes[i]->pid);
         }
+    }
+    return pids;
+}
 
-        if(spaceLeft <= 0){
-            return 0;
-        }else{
-            return spaceLeft;
-        }
+/** Size of the virtual address space every process gets **/
+uint32_t Mmu::getProcessSize(){ return _process_size; }
 
+uint32_t Mmu::getFirstPid(){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    return _first_pid;
+}
 
+AllocatorStats Mmu::getAllocatorStats(){
+    std::lock_guard<std::mutex> stats_guard(_stats_lock);
+    return _alloc_stats;
+}
 
-    }else{
-        return 0;
+/** Resets an empty process table to a saved PID range, every slot terminated until restoreProcess() fills it **/
+void Mmu::restoreProcessTable(uint32_t first_pid, uint32_t next_pid, const AllocatorStats &stats){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    _first_pid = first_pid;
+    _next_pid = next_pid;
+    _processes.assign(next_pid - first_pid, NULL);
+    _num_processes = 0;
+    std::lock_guard<std::mutex> stats_guard(_stats_lock);
+    _alloc_stats = stats;
+}
+
+/** Brings back a saved process with an empty heap; its variables are added with addVariableToProcess() and its free
+    blocks restored on the heap. Returns NULL if the PID is outside the restored range or already taken **/
+Process* Mmu::restoreProcess(uint32_t pid, uint32_t reserved_bytes){
+    std::lock_guard<std::mutex> guard(_table_lock);
+    if(pid < _first_pid || pid - _first_pid >= _processes.size() || _processes[pid - _first_pid] != NULL){
+        return NULL;
     }
-}
\ No newline at end of file
+    Process *proc = _process_pool.create();
+    proc->pid = pid;
+    proc->variable_pool.setCache(&_variable_slabs);
+    proc->used_bytes = 0;
+    proc->reserved_bytes = reserved_bytes;
+    proc->heap = createHeapAllocator(_policy, _process_size);
+    _reserved_bytes += reserved_bytes;
+
+    _processes[pid - _first_pid] = proc;
+    _num_processes++;
+    return proc;
+}
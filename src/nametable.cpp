@@ -0,0 +1,60 @@
+#include "nametable.h"
+
+NameTable::NameTable()
+{
+}
+
+NameTable::~NameTable()
+{
+}
+
+/** Returns the id of a name, adding it to the table the first time it is seen, and takes a reference to it **/
+uint32_t NameTable::intern(const std::string &name)
+{
+    std::unordered_map<std::string, uint32_t>::iterator it = _ids.find(name);
+    if (it != _ids.end())
+    {
+        _names[it->second].references++;
+        return it->second;
+    }
+
+    uint32_t id = (uint32_t)_names.size();
+    if (!_free_ids.empty())
+    {
+        id = _free_ids.back();
+        _free_ids.pop_back();
+    }
+    else
+    {
+        _names.push_back(NameEntry());
+    }
+    // Keys of an unordered_map never move, so the table can point straight at them
+    it = _ids.insert(std::make_pair(name, id)).first;
+    _names[id].name = &it->first;
+    _names[id].references = 1;
+    return id;
+}
+
+/** Drops a reference taken by intern(); the name is forgotten, and its id free for reuse, once none are left **/
+void NameTable::release(uint32_t id)
+{
+    NameEntry &entry = _names[id];
+    if (--entry.references == 0)
+    {
+        _ids.erase(*entry.name);
+        entry.name = NULL;
+        _free_ids.push_back(id);
+    }
+}
+
+/** Returns the id of a name without adding it, or NOT_FOUND if no live variable uses it **/
+uint32_t NameTable::find(const std::string &name)
+{
+    std::unordered_map<std::string, uint32_t>::const_iterator it = _ids.find(name);
+    return (it != _ids.end()) ? it->second : NOT_FOUND;
+}
+
+const std::string& NameTable::getName(uint32_t id)
+{
+    return *_names[id].name;
+}
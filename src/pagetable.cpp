@@ -1,73 +1,177 @@
 #include "pagetable.h"
+#include "stats.h"
 #include <cmath>
+#include <cstring>
 
-PageTable::PageTable(int page_size)
+/** Frees a PageMap once the epoch domain says no reader can still see it **/
+static void destroyPageMap(void *object)
 {
+    PageMap *map = (PageMap*)object;
+    delete[] map->frames;
+    delete map;
+}
+
+PageTable::PageTable(int page_size, uint64_t memory_size) : _directory(new std::atomic<std::atomic<PageMap*>*>[DIRECTORY_SIZE]),
+    _frames((uint32_t)(memory_size / page_size))
+{
+    for (uint32_t i = 0; i < DIRECTORY_SIZE; i++)
+    {
+        _directory[i].store(NULL, std::memory_order_relaxed);
+    }
     _page_size = page_size;
+    _tlb = NULL;
+    _memory = NULL;
+    _swap = NULL;
+    _replacer = NULL;
+    _paging_stats = PagingStats();
 }
 
 PageTable::~PageTable()
 {
+    delete _replacer;
+    for (uint32_t i = 0; i < DIRECTORY_SIZE; i++)
+    {
+        std::atomic<PageMap*> *leaf = _directory[i].load();
+        if (leaf == NULL)
+        {
+            continue;
+        }
+        for (uint32_t j = 0; j < DIRECTORY_SIZE; j++)
+        {
+            PageMap *map = leaf[j].load();
+            if (map != NULL)
+            {
+                destroyPageMap(map);
+            }
+        }
+        delete[] leaf;
+    }
+}
+
+/** Shard holding every page of a process **/
+PageTableShard& PageTable::shardOf(uint32_t pid)
+{
+    return _shards[pid % NUM_SHARDS];
 }
 
-std::vector<std::string> PageTable::sortedKeys()
+/** Adds an entry to the page table, returns false if there is no free frame left to map it to **/
+bool PageTable::addEntry(uint32_t pid, int page_number)
 {
-    std::vector<std::string> keys;
+    STAT_SCOPE(StatMap);
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
 
-    std::map<std::string, int>::iterator it;
-    for (it = _table.begin(); it != _table.end(); it++)
+    // Combination of pid and page number act as the key to look up frame number
+    uint64_t entry = pageTableKey(pid, page_number);
+
+    // Pages shared by several variables are only mapped once
+    if (shard.table.count(entry) > 0)
     {
-        keys.push_back(it->first);
+        return true;
     }
 
-    std::sort(keys.begin(), keys.end(), PageTableKeyComparator());
+    // Take the lowest free frame from the frame allocator
+    int frame = _frames.allocate();
+    if (frame < 0)
+    {
+        return false;
+    }
 
-    return keys;
+    // Once a free frame has been found, add the key-value pair
+    PageTableEntry pte = {frame, -1, PagePresent};
+    shard.table.insert(std::make_pair(entry, pte));
+    shard.process_pages[pid].push_back(page_number);
+    publishFrame(pid, page_number, frame);
+    return true;
 }
 
-/** Adds an entry to the page table **/
-void PageTable::addEntry(uint32_t pid, int page_number)
+/** Maps a page to one particular frame, as saved in a checkpoint; returns false if the page is already mapped or the frame is taken **/
+bool PageTable::restoreMapping(uint32_t pid, int page_number, int frame)
 {
-    // Combination of pid and page number act as the key to look up frame number
-    std::string entry = std::to_string(pid) + "|" + std::to_string(page_number);
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
 
-    // Starting at frame 0, check mappings...
-    int frame = 0; 
-    for (std::map<std::string, int>::iterator it=_table.begin(); it!=_table.end(); ++it) {
-        // Check and see if the current frame has been mapped to
-        if(it->second == frame) {
-            // If so, look at the next frame
-            frame++;
-        }
+    uint64_t entry = pageTableKey(pid, page_number);
+    if (shard.table.count(entry) > 0 || !_frames.claim(frame))
+    {
+        return false;
     }
 
-    // Once a free frame has been found, add the key-value pair
-    _table.insert(std::make_pair(entry, frame));
+    PageTableEntry pte = {frame, -1, PagePresent};
+    shard.table.insert(std::make_pair(entry, pte));
+    shard.process_pages[pid].push_back(page_number);
+    publishFrame(pid, page_number, frame);
+    return true;
+}
+
+/** Demand paging: records a page as belonging to the process without giving it a frame; the first access faults it in **/
+void PageTable::reserveEntry(uint32_t pid, int page_number)
+{
+    STAT_SCOPE(StatMap);
+    std::lock_guard<std::mutex> paging_guard(_paging_lock);
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    PageTableEntry pte = {-1, -1, 0};
+    if (shard.table.insert(std::make_pair(pageTableKey(pid, page_number), pte)).second)
+    {
+        shard.process_pages[pid].push_back(page_number);
+    }
 }
 
 /** Calculates the physical address given a PID and a virtual address **/
-int PageTable::getPhysicalAddress(uint32_t pid, uint32_t virtual_address)
+uint64_t PageTable::getPhysicalAddress(uint32_t pid, uint32_t virtual_address, bool write)
 {
+    STAT_SCOPE(StatTranslate);
     // Page offset can be found using modulus; page offset is the distance (in bytes) relative to the start of the page
     int page_offset = virtual_address % _page_size;
     // Call getPageNumber() to find the page number for the passed-in virtual address
     int page_number = PageTable::getPageNumber(virtual_address);
-    // Combination of pid and page number act as the key to look up frame number in the page table
-    std::string entry = std::to_string(pid) + "|" + std::to_string(page_number);
     
-    // If entry exists, look up frame number in the page table
-    int address = -1;
-    int frame_number = 0;
-    if (_table.count(entry) > 0) 
-    { 
-        frame_number = _table.at(entry); 
+    // Without demand paging a translation only needs an epoch, so the PageMap it reads can't be freed underneath it.
+    // Demand paging (or a thread that couldn't get an epoch slot) goes through the locks
+    EpochGuard epoch;
+    bool lock_free = (_replacer == NULL && epoch.active());
+    PageTableShard &shard = shardOf(pid);
+    std::unique_lock<std::mutex> paging_guard(_paging_lock, std::defer_lock);
+    std::unique_lock<std::mutex> shard_guard(shard.lock, std::defer_lock);
+    if (!lock_free)
+    {
+        if (_replacer != NULL) { paging_guard.lock(); }
+        shard_guard.lock();
+    }
+
+    // Unmapped pages translate to frame 0
+    int frame_number = lock_free ? translateFrame(pid, page_number) : lookupFrame(shard, pid, page_number, write);
+    if (frame_number < 0)
+    {
+        frame_number = 0;
     }
 
     // Physical address = [physical page number (a.k.a. frame number) * page size] + offset
-    address = (frame_number * _page_size) + page_offset;
+    return ((uint64_t)frame_number * _page_size) + page_offset;
+}
 
-    // Return the physical address
-    return address;
+/** Appends every mapping, sorted by PID and then page number; pages without a frame (evicted under demand paging) are left out **/
+void PageTable::getMappings(std::vector<PageMapping> &mappings)
+{
+    size_t first = mappings.size();
+    for (int i = 0; i < NUM_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> guard(_shards[i].lock);
+        std::unordered_map<uint64_t, PageTableEntry> &table = _shards[i].table;
+        for (std::unordered_map<uint64_t, PageTableEntry>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            if (it->second.frame >= 0)
+            {
+                PageMapping mapping = {pageTableKeyPid(it->first), pageTableKeyPage(it->first), it->second.frame};
+                mappings.push_back(mapping);
+            }
+        }
+    }
+    std::sort(mappings.begin() + first, mappings.end(), [](const PageMapping &a, const PageMapping &b) {
+        return pageTableKey(a.pid, a.page) < pageTableKey(b.pid, b.page);
+    });
 }
 
 /** Prints all pages in the page table **/
@@ -75,28 +179,33 @@ void PageTable::print()
 {
     int i;
 
-    std::cout << " PID  | Page Number | Frame Number" << std::endl;
-    std::cout << "------+-------------+--------------" << std::endl;
+    if (_replacer != NULL)
+    {
+        printDemandPaged();
+        return;
+    }
 
-    std::vector<std::string> keys = sortedKeys();
+    std::cout << " PID  | Page Number | Frame Number" << "\n";
+    std::cout << "------+-------------+--------------" << "\n";
+
+    // Packed keys sort by PID first, then by page number
+    std::vector<std::pair<uint64_t, int> > entries;
+    for (i = 0; i < NUM_SHARDS; i++)
+    {
+        std::lock_guard<std::mutex> guard(_shards[i].lock);
+        std::unordered_map<uint64_t, PageTableEntry> &table = _shards[i].table;
+        for (std::unordered_map<uint64_t, PageTableEntry>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            entries.push_back(std::make_pair(it->first, it->second.frame));
+        }
+    }
+    std::sort(entries.begin(), entries.end());
 
     // For all keys, in sorted order...
-    for (i = 0; i < keys.size(); i++)
+    for (i = 0; i < entries.size(); i++)
     {   
-        // Format the current key-value pair for printing
-        /*
-        std::string pid = keys[i].substr(0, 3);
-        std::string page_number = keys[i].substr(), 3);
-        */
-        int frame_number = _table[keys[i]];
-        
-
-        keys[i].insert(4, " ");
-        if(stoi(keys[i].substr(6)) < 10) { keys[i].insert(6, "           "); }
-        else { keys[i].insert(6, "          "); }
-
-        // Print the key (which includes the PID and Page Number) and also the value associated with that key (the Frame Number) 
-        printf(" %5s | %12u\n", keys[i].c_str(), frame_number);
+        // Print the PID, the Page Number and the Frame Number mapped to them
+        printf(" %4u | %11u | %12d\n", pageTableKeyPid(entries[i].first), pageTableKeyPage(entries[i].first), entries[i].second);
     }
 }
 
@@ -104,29 +213,75 @@ void PageTable::print()
 int PageTable::getPageSize(){ return _page_size; }
 
 void PageTable::freeAllPagesOfProcess(uint32_t pid) {
-    std::vector<std::string> keys = sortedKeys();
+    std::unique_lock<std::mutex> paging_guard(_paging_lock, std::defer_lock);
+    if (_replacer != NULL) { paging_guard.lock(); }
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    std::unordered_map<uint32_t, std::vector<uint32_t> >::iterator pages = shard.process_pages.find(pid);
+    if (pages == shard.process_pages.end())
+    {
+        return;
+    }
+
+    // Unpublish before flushing the TLB, so a lock-free translation can't put a stale entry back after the flush
+    if (_replacer == NULL) { unpublishProcess(pid); }
+    if (_tlb != NULL)
+    {
+        std::lock_guard<std::mutex> tlb_guard(_tlb_lock);
+        _tlb->invalidateProcess(pid);
+    }
 
-    for (int i = 0; i < keys.size(); i++)
+    // Only visit the pages this process actually mapped
+    for (size_t i = 0; i < pages->second.size(); i++)
     {
-        // look at each key, and if the key contains the substring "PID" (PID converted to string using stoi()) remove that key-value pair
-        if(keys[i].find(std::to_string(pid)) != std::string::npos) {
-            _table.erase(keys[i]);
+        std::unordered_map<uint64_t, PageTableEntry>::iterator it = shard.table.find(pageTableKey(pid, pages->second[i]));
+        if (it != shard.table.end())
+        {
+            releaseEntry(it->second);
+            shard.table.erase(it);
         }
     }
+    shard.process_pages.erase(pages);
 }
 
 void PageTable::freeSinglePage(uint32_t pid, int page) {
-    std::vector<std::string> keys = sortedKeys();
+    std::unique_lock<std::mutex> paging_guard(_paging_lock, std::defer_lock);
+    if (_replacer != NULL) { paging_guard.lock(); }
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
 
-    
-    for (int i = 0; i < keys.size(); i++)
+    std::unordered_map<uint64_t, PageTableEntry>::iterator it = shard.table.find(pageTableKey(pid, page));
+    if (it == shard.table.end())
+    {
+        return;
+    }
+
+    // Hand the frame straight back so the next mapping can reuse it; unpublish first, as in freeAllPagesOfProcess()
+    if (_replacer == NULL) { publishFrame(pid, page, -1); }
+    if (_tlb != NULL)
+    {
+        std::lock_guard<std::mutex> tlb_guard(_tlb_lock);
+        _tlb->invalidate(pid, page);
+    }
+    releaseEntry(it->second);
+    shard.table.erase(it);
+
+    // Remove the page from the process's page list (order doesn't matter, so swap with the last one)
+    std::vector<uint32_t> &pages = shard.process_pages[pid];
+    for (size_t i = 0; i < pages.size(); i++)
     {
-        // look at each key, and if the key contains the substring "PID" (PID converted to string using stoi()) remove that key-value pair
-        if((keys[i].find(std::to_string(pid)) != std::string::npos) && (keys[i].find(std::to_string(page)) != std::string::npos)) {
-            _table.erase(keys[i]);
+        if (pages[i] == (uint32_t)page)
+        {
+            pages[i] = pages.back();
+            pages.pop_back();
             break;
         }
     }
+    if (pages.empty())
+    {
+        shard.process_pages.erase(pid);
+    }
 }
 
 /** Calculates a page number using a virtual address and a page size **/
@@ -134,3 +289,429 @@ int PageTable::getPageNumber(uint32_t address) {
     // The page number is the number of pages counting up from 0
     return floor(address / _page_size);
 }
+
+uint32_t PageTable::getNumFrames() { return _frames.getNumFrames(); }
+
+/** Number of physical frames not currently mapped to any page **/
+uint32_t PageTable::getFreeFrames() { return _frames.getFreeFrames(); }
+
+/** Frame backing a page, trying the TLB first and filling it on a miss; -1 if the page is not mapped (or, with demand paging, can't be faulted in).
+    The caller holds the shard lock, and the paging lock too when demand paging is on **/
+int PageTable::lookupFrame(PageTableShard &shard, uint32_t pid, int page_number, bool write)
+{
+    int frame_number;
+    if (_replacer == NULL)
+    {
+        if (_tlb != NULL)
+        {
+            std::lock_guard<std::mutex> tlb_guard(_tlb_lock);
+            if (_tlb->lookup(pid, page_number, &frame_number))
+            {
+                return frame_number;
+            }
+        }
+
+        std::unordered_map<uint64_t, PageTableEntry>::const_iterator it = shard.table.find(pageTableKey(pid, page_number));
+        if (it == shard.table.end())
+        {
+            return -1;
+        }
+        if (_tlb != NULL)
+        {
+            std::lock_guard<std::mutex> tlb_guard(_tlb_lock);
+            _tlb->insert(pid, page_number, it->second.frame);
+        }
+        return it->second.frame;
+    }
+
+    // Demand paging: every access still goes through the entry so the dirty and referenced bits and the
+    // replacer see it; the TLB only models hits and misses. The paging lock already serializes everything here
+    bool tlb_hit = (_tlb != NULL && _tlb->lookup(pid, page_number, &frame_number));
+    uint64_t key = pageTableKey(pid, page_number);
+    std::unordered_map<uint64_t, PageTableEntry>::iterator it = shard.table.find(key);
+    if (it == shard.table.end())
+    {
+        return -1;
+    }
+
+    PageTableEntry &entry = it->second;
+    _paging_stats.accesses++;
+    if (entry.flags & PagePresent)
+    {
+        _replacer->accessed(entry.frame);
+    }
+    else if (handleFault(key, entry) < 0)
+    {
+        return -1;
+    }
+    entry.flags |= PageReferenced | (write ? PageDirty : 0);
+    if (_tlb != NULL && !tlb_hit) { _tlb->insert(pid, page_number, entry.frame); }
+    return entry.frame;
+}
+
+/** Lock-free lookup of the frame behind a page, -1 if it isn't mapped; the caller must be inside an epoch **/
+int PageTable::readFrame(uint32_t pid, int page_number)
+{
+    std::atomic<PageMap*> *leaf = _directory[pid >> 16].load();
+    if (leaf == NULL)
+    {
+        return -1;
+    }
+    PageMap *map = leaf[pid & (DIRECTORY_SIZE - 1)].load();
+    if (map == NULL || (uint32_t)page_number >= map->num_pages)
+    {
+        return -1;
+    }
+    return map->frames[page_number].load(std::memory_order_acquire);
+}
+
+/** lookupFrame() without the page table locks, for when demand paging is off. The TLB is still a single shared
+    structure, so it keeps its lock, and the walk happens under it so a fill can't race with an invalidation **/
+int PageTable::translateFrame(uint32_t pid, int page_number)
+{
+    if (_tlb == NULL)
+    {
+        return readFrame(pid, page_number);
+    }
+
+    int frame_number;
+    std::lock_guard<std::mutex> tlb_guard(_tlb_lock);
+    if (_tlb->lookup(pid, page_number, &frame_number))
+    {
+        return frame_number;
+    }
+    frame_number = readFrame(pid, page_number);
+    if (frame_number >= 0)
+    {
+        _tlb->insert(pid, page_number, frame_number);
+    }
+    return frame_number;
+}
+
+/** A process's slot in the PID directory, making its leaf if this is the first process there **/
+std::atomic<PageMap*>& PageTable::pageMapSlot(uint32_t pid)
+{
+    std::atomic<std::atomic<PageMap*>*> &entry = _directory[pid >> 16];
+    std::atomic<PageMap*> *leaf = entry.load();
+    if (leaf == NULL)
+    {
+        // Writers in two shards can race to make the same leaf; the loser throws its copy away
+        std::atomic<PageMap*> *fresh = new std::atomic<PageMap*>[DIRECTORY_SIZE];
+        for (uint32_t i = 0; i < DIRECTORY_SIZE; i++)
+        {
+            fresh[i].store(NULL, std::memory_order_relaxed);
+        }
+        if (entry.compare_exchange_strong(leaf, fresh))
+        {
+            leaf = fresh;
+        }
+        else
+        {
+            delete[] fresh;
+        }
+    }
+    return leaf[pid & (DIRECTORY_SIZE - 1)];
+}
+
+/** Makes a mapping change visible to lock-free readers (frame -1 unmaps the page). The caller holds the process's
+    shard lock, so it is the only writer of this PageMap; outgrowing it publishes a doubled copy and retires the old one **/
+void PageTable::publishFrame(uint32_t pid, int page_number, int frame)
+{
+    std::atomic<PageMap*> &slot = pageMapSlot(pid);
+    PageMap *map = slot.load();
+    if (map == NULL || (uint32_t)page_number >= map->num_pages)
+    {
+        if (frame < 0)
+        {
+            return;
+        }
+
+        uint32_t num_pages = std::max<uint32_t>(page_number + 1, map != NULL ? 2 * map->num_pages : 16);
+        PageMap *grown = new PageMap;
+        grown->num_pages = num_pages;
+        grown->frames = new std::atomic<int>[num_pages];
+        for (uint32_t i = 0; i < num_pages; i++)
+        {
+            int copied = (map != NULL && i < map->num_pages) ? map->frames[i].load(std::memory_order_relaxed) : -1;
+            grown->frames[i].store(copied, std::memory_order_relaxed);
+        }
+        slot.store(grown);
+        if (map != NULL)
+        {
+            EpochDomain::global().retire(map, destroyPageMap);
+        }
+        map = grown;
+    }
+    map->frames[page_number].store(frame, std::memory_order_release);
+}
+
+/** Drops a terminated process's PageMap from the directory; readers still holding it keep it alive until they leave their epoch **/
+void PageTable::unpublishProcess(uint32_t pid)
+{
+    std::atomic<PageMap*> *leaf = _directory[pid >> 16].load();
+    if (leaf == NULL)
+    {
+        return;
+    }
+    PageMap *map = leaf[pid & (DIRECTORY_SIZE - 1)].exchange(NULL);
+    if (map != NULL)
+    {
+        EpochDomain::global().retire(map, destroyPageMap);
+    }
+}
+
+/** Brings a non-resident page into a frame, evicting another page if none are free; returns the frame or -1 **/
+int PageTable::handleFault(uint64_t key, PageTableEntry &entry)
+{
+    _paging_stats.faults++;
+    int frame = _frames.allocate();
+    if (frame < 0)
+    {
+        frame = evictPage(key);
+        if (frame < 0)
+        {
+            return -1;
+        }
+    }
+
+    // Pages that were never written back start out zero-filled
+    uint8_t *page = _memory + (uint64_t)frame * _page_size;
+    if (entry.swap_slot >= 0)
+    {
+        if (!_swap->read(entry.swap_slot, page))
+        {
+            _frames.release(frame);
+            return -1;
+        }
+        _paging_stats.swap_ins++;
+    }
+    else
+    {
+        memset(page, 0, _page_size);
+    }
+
+    entry.frame = frame;
+    entry.flags = PagePresent;
+    _frame_owner[frame] = key;
+    _replacer->loaded(frame, key);
+    return frame;
+}
+
+/** Pushes the replacer's victim out of its frame to make room for incoming, writing it to swap if it has changed; returns the freed frame or -1 **/
+int PageTable::evictPage(uint64_t incoming)
+{
+    int frame = _replacer->selectVictim(incoming);
+    if (frame < 0)
+    {
+        return -1;
+    }
+    // The victim can belong to any process; the paging lock keeps every shard still while we touch it
+    uint64_t key = _frame_owner[frame];
+    PageTableEntry &victim = shardOf(pageTableKeyPid(key)).table.find(key)->second;
+
+    // A clean page either matches its swap copy or was never written at all, so it can just be dropped
+    if (victim.flags & PageDirty)
+    {
+        if (victim.swap_slot < 0)
+        {
+            victim.swap_slot = _swap->allocate();
+        }
+        if (victim.swap_slot < 0 || !_swap->write(victim.swap_slot, _memory + (uint64_t)frame * _page_size))
+        {
+            return -1;
+        }
+        _paging_stats.write_backs++;
+    }
+
+    victim.frame = -1;
+    victim.flags = 0;
+    _replacer->evicted(frame);
+    if (_tlb != NULL) { _tlb->invalidate(pageTableKeyPid(key), pageTableKeyPage(key)); }
+    _paging_stats.evictions++;
+    return frame;
+}
+
+/** Returns whatever an entry holds (its frame, its swap slot) to the free pools **/
+void PageTable::releaseEntry(PageTableEntry &entry)
+{
+    if (entry.flags & PagePresent)
+    {
+        _frames.release(entry.frame);
+        if (_replacer != NULL) { _replacer->removed(entry.frame); }
+    }
+    if (entry.swap_slot >= 0)
+    {
+        _swap->release(entry.swap_slot);
+    }
+}
+
+/** Translates a virtual range into the physical extents backing it, one lookup per page; pages in adjacent frames are merged into one extent.
+    Returns false if any page in the range is unmapped. With demand paging, a fault later in the range can evict a page from earlier in it,
+    so ranges should not span more pages than there are frames **/
+bool PageTable::translateRange(uint32_t pid, uint32_t virtual_address, uint32_t length, std::vector<PhysicalExtent> &extents, bool write)
+{
+    STAT_SCOPE(StatTranslate);
+    extents.clear();
+
+    // One epoch, or one lock acquisition, covers the whole range
+    EpochGuard epoch;
+    bool lock_free = (_replacer == NULL && epoch.active());
+    PageTableShard &shard = shardOf(pid);
+    std::unique_lock<std::mutex> paging_guard(_paging_lock, std::defer_lock);
+    std::unique_lock<std::mutex> shard_guard(shard.lock, std::defer_lock);
+    if (!lock_free)
+    {
+        if (_replacer != NULL) { paging_guard.lock(); }
+        shard_guard.lock();
+    }
+
+    while (length > 0)
+    {
+        int page_number = getPageNumber(virtual_address);
+        uint32_t page_offset = virtual_address % _page_size;
+        uint32_t chunk = std::min(length, (uint32_t)_page_size - page_offset);
+
+        int frame_number = lock_free ? translateFrame(pid, page_number) : lookupFrame(shard, pid, page_number, write);
+        if (frame_number < 0)
+        {
+            return false;
+        }
+
+        // Extend the previous extent when this page starts right where it ended
+        PhysicalExtent *last = extents.empty() ? NULL : &extents.back();
+        if (last != NULL && page_offset == 0 &&
+            (uint64_t)last->frame * _page_size + last->offset + last->length == (uint64_t)frame_number * _page_size)
+        {
+            last->length += chunk;
+        }
+        else
+        {
+            PhysicalExtent extent = {frame_number, page_offset, chunk};
+            extents.push_back(extent);
+        }
+
+        virtual_address += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/** Copies length bytes between a buffer and a process's virtual memory with demand paging on, a page at a time.
+    Each page is translated and copied under the paging lock, so another thread's fault can't evict the frame and
+    hand it to a different process halfway; returns false if a page isn't mapped or can't be faulted in **/
+bool PageTable::copyPaged(uint32_t pid, uint32_t virtual_address, uint8_t *buffer, uint32_t length, bool write)
+{
+    PageTableShard &shard = shardOf(pid);
+    while (length > 0)
+    {
+        STAT_SCOPE(StatTranslate);
+        uint32_t page_offset = virtual_address % _page_size;
+        uint32_t chunk = std::min(length, (uint32_t)_page_size - page_offset);
+        {
+            std::lock_guard<std::mutex> paging_guard(_paging_lock);
+            std::lock_guard<std::mutex> shard_guard(shard.lock);
+            int frame_number = lookupFrame(shard, pid, getPageNumber(virtual_address), write);
+            if (frame_number < 0)
+            {
+                return false;
+            }
+            uint8_t *physical = _memory + (uint64_t)frame_number * _page_size + page_offset;
+            if (write) {
+                memcpy(physical, buffer, chunk);
+            } else {
+                memcpy(buffer, physical, chunk);
+            }
+        }
+        buffer += chunk;
+        virtual_address += chunk;
+        length -= chunk;
+    }
+    return true;
+}
+
+/** Puts a TLB in front of getPhysicalAddress(); the page table does not take ownership of it **/
+void PageTable::setTlb(Tlb *tlb) { _tlb = tlb; }
+
+Tlb* PageTable::getTlb() { return _tlb; }
+
+/** Number of pages currently mapped by a process **/
+size_t PageTable::getNumPagesOfProcess(uint32_t pid)
+{
+    std::unique_lock<std::mutex> paging_guard(_paging_lock, std::defer_lock);
+    if (_replacer != NULL) { paging_guard.lock(); }
+    PageTableShard &shard = shardOf(pid);
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    std::unordered_map<uint32_t, std::vector<uint32_t> >::iterator pages = shard.process_pages.find(pid);
+    return (pages != shard.process_pages.end()) ? pages->second.size() : 0;
+}
+
+/** Switches to demand paging: pages are reserved up front and only get a frame when first touched.
+    The page table takes ownership of the replacer but not of the swap file. Call once at startup, before other threads use the table **/
+void PageTable::enableDemandPaging(uint8_t *memory, SwapFile *swap, PageReplacer *replacer)
+{
+    _memory = memory;
+    _swap = swap;
+    delete _replacer;
+    _replacer = replacer;
+    _frame_owner.assign(_frames.getNumFrames(), 0);
+}
+
+bool PageTable::isDemandPaging() { return _replacer != NULL; }
+
+PagingStats PageTable::getPagingStats()
+{
+    std::lock_guard<std::mutex> paging_guard(_paging_lock);
+    return _paging_stats;
+}
+
+/** Page table with residency, swap slot and flags (P = present, D = dirty, R = referenced) **/
+void PageTable::printDemandPaged()
+{
+    std::cout << " PID  | Page Number | Frame Number | Swap Slot | Flags" << "\n";
+    std::cout << "------+-------------+--------------+-----------+-------" << "\n";
+
+    // The paging lock keeps every shard still, so entries can be read in place
+    std::lock_guard<std::mutex> paging_guard(_paging_lock);
+    std::vector<std::pair<uint64_t, const PageTableEntry*> > entries;
+    for (int i = 0; i < NUM_SHARDS; i++)
+    {
+        std::unordered_map<uint64_t, PageTableEntry> &table = _shards[i].table;
+        for (std::unordered_map<uint64_t, PageTableEntry>::iterator it = table.begin(); it != table.end(); ++it)
+        {
+            entries.push_back(std::make_pair(it->first, &it->second));
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        const PageTableEntry &entry = *entries[i].second;
+        char flags[4] = {
+            (char)((entry.flags & PagePresent) ? 'P' : '-'),
+            (char)((entry.flags & PageDirty) ? 'D' : '-'),
+            (char)((entry.flags & PageReferenced) ? 'R' : '-'),
+            '\0'
+        };
+        char frame[16] = "-";
+        char slot[16] = "-";
+        if (entry.flags & PagePresent) { snprintf(frame, sizeof(frame), "%d", entry.frame); }
+        if (entry.swap_slot >= 0) { snprintf(slot, sizeof(slot), "%d", entry.swap_slot); }
+        printf(" %4u | %11u | %12s | %9s | %s\n", pageTableKeyPid(entries[i].first), pageTableKeyPage(entries[i].first), frame, slot, flags);
+    }
+}
+
+/** Prints fault, swap and eviction counts for demand paging **/
+void PageTable::printPagingStats()
+{
+    std::lock_guard<std::mutex> paging_guard(_paging_lock);
+    PagingStats &stats = _paging_stats;
+    printf("Paging: %s replacement, %u of %u frames free, %u of %u swap slots free\n", _replacer->getName(),
+        _frames.getFreeFrames(), _frames.getNumFrames(), _swap->getFreeSlots(), _swap->getNumSlots());
+    printf("  accesses:    %llu\n", (unsigned long long)stats.accesses);
+    printf("  faults:      %llu (%.2f%%)\n", (unsigned long long)stats.faults,
+        stats.accesses > 0 ? 100.0 * stats.faults / stats.accesses : 0.0);
+    printf("  swap-ins:    %llu\n", (unsigned long long)stats.swap_ins);
+    printf("  evictions:   %llu\n", (unsigned long long)stats.evictions);
+    printf("  write-backs: %llu\n", (unsigned long long)stats.write_backs);
+}
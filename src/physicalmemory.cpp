@@ -0,0 +1,77 @@
+#include "physicalmemory.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+PhysicalMemory::PhysicalMemory(uint64_t size, bool huge_pages)
+{
+    _size = size;
+    _huge_pages = huge_pages;
+
+    // MAP_NORESERVE: don't reserve swap for the whole range, untouched frames cost nothing
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    _base = (base != MAP_FAILED) ? (uint8_t*)base : NULL;
+
+#ifdef MADV_HUGEPAGE
+    // Only advice: the kernel falls back to normal pages if transparent huge pages are unavailable
+    if (_base != NULL && huge_pages)
+    {
+        madvise(_base, size, MADV_HUGEPAGE);
+    }
+#endif
+}
+
+PhysicalMemory::~PhysicalMemory()
+{
+    if (_base != NULL)
+    {
+        munmap(_base, _size);
+    }
+}
+
+bool PhysicalMemory::isMapped(){ return _base != NULL; }
+
+uint8_t* PhysicalMemory::getBase(){ return _base; }
+
+uint64_t PhysicalMemory::getSize(){ return _size; }
+
+/** Host RAM actually backing the simulated memory, counted one host page at a time **/
+uint64_t PhysicalMemory::getResidentBytes()
+{
+    if (_base == NULL)
+    {
+        return 0;
+    }
+    uint64_t host_page = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((_size + host_page - 1) / host_page);
+    if (mincore(_base, _size, resident.data()) != 0)
+    {
+        return 0;
+    }
+
+    uint64_t pages = 0;
+    for (size_t i = 0; i < resident.size(); i++)
+    {
+        pages += resident[i] & 1;
+    }
+    return pages * host_page;
+}
+
+/** Replaces the whole contents with an image stored in a file at offset (a multiple of the host page size). The file is
+    mapped copy-on-write in place of the current memory, so nothing is read until a frame is touched and writes never
+    reach the file **/
+bool PhysicalMemory::mapImage(int fd, off_t offset)
+{
+    if (_base == NULL)
+    {
+        return false;
+    }
+    if (mmap(_base, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, fd, offset) != MAP_FAILED)
+    {
+        return true;
+    }
+
+    // A failed fixed mapping may already have dropped the old one, so put fresh zeroed memory back in its place
+    mmap(_base, _size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED | MAP_NORESERVE, -1, 0);
+    return false;
+}
@@ -0,0 +1,345 @@
+#include "replacement.h"
+#include <algorithm>
+
+PageReplacer::PageReplacer(uint32_t num_frames)
+{
+    _num_frames = num_frames;
+}
+
+PageReplacer::~PageReplacer()
+{
+}
+
+uint32_t PageReplacer::getNumFrames(){ return _num_frames; }
+
+FrameList::FrameList(uint32_t num_frames)
+{
+    _prev.assign(num_frames, -1);
+    _next.assign(num_frames, -1);
+    _member.assign(num_frames, 0);
+    _head = -1;
+    _tail = -1;
+    _size = 0;
+}
+
+void FrameList::pushBack(int frame)
+{
+    _prev[frame] = _tail;
+    _next[frame] = -1;
+    if (_tail >= 0) { _next[_tail] = frame; } else { _head = frame; }
+    _tail = frame;
+    _member[frame] = 1;
+    _size++;
+}
+
+void FrameList::remove(int frame)
+{
+    if (!_member[frame])
+    {
+        return;
+    }
+    if (_prev[frame] >= 0) { _next[_prev[frame]] = _next[frame]; } else { _head = _next[frame]; }
+    if (_next[frame] >= 0) { _prev[_next[frame]] = _prev[frame]; } else { _tail = _prev[frame]; }
+    _member[frame] = 0;
+    _size--;
+}
+
+bool FrameList::contains(int frame) { return _member[frame] != 0; }
+
+int FrameList::front() { return _head; }
+
+uint32_t FrameList::size() { return _size; }
+
+ClockReplacer::ClockReplacer(uint32_t num_frames) : PageReplacer(num_frames)
+{
+    _resident.assign(num_frames, 0);
+    _referenced.assign(num_frames, 0);
+    _num_resident = 0;
+    _hand = 0;
+}
+
+void ClockReplacer::loaded(int frame, uint64_t page)
+{
+    if (!_resident[frame])
+    {
+        _resident[frame] = 1;
+        _num_resident++;
+    }
+    _referenced[frame] = 1;
+}
+
+void ClockReplacer::accessed(int frame) { _referenced[frame] = 1; }
+
+void ClockReplacer::evicted(int frame) { removed(frame); }
+
+void ClockReplacer::removed(int frame)
+{
+    if (_resident[frame])
+    {
+        _resident[frame] = 0;
+        _num_resident--;
+    }
+    _referenced[frame] = 0;
+}
+
+int ClockReplacer::selectVictim(uint64_t incoming)
+{
+    if (_num_resident == 0)
+    {
+        return -1;
+    }
+
+    // Every referenced page gets one pass of grace, so two sweeps always find a victim
+    for (;;)
+    {
+        uint32_t frame = _hand;
+        _hand = (_hand + 1) % _num_frames;
+        if (!_resident[frame])
+        {
+            continue;
+        }
+        if (_referenced[frame])
+        {
+            _referenced[frame] = 0;
+            continue;
+        }
+        return frame;
+    }
+}
+
+const char* ClockReplacer::getName() { return "clock"; }
+
+FifoReplacer::FifoReplacer(uint32_t num_frames) : PageReplacer(num_frames), _queue(num_frames)
+{
+}
+
+void FifoReplacer::loaded(int frame, uint64_t page)
+{
+    _queue.remove(frame);
+    _queue.pushBack(frame);
+}
+
+void FifoReplacer::accessed(int frame) {}
+
+void FifoReplacer::evicted(int frame) { _queue.remove(frame); }
+
+void FifoReplacer::removed(int frame) { _queue.remove(frame); }
+
+int FifoReplacer::selectVictim(uint64_t incoming) { return _queue.front(); }
+
+const char* FifoReplacer::getName() { return "fifo"; }
+
+LruReplacer::LruReplacer(uint32_t num_frames) : PageReplacer(num_frames), _recency(num_frames)
+{
+}
+
+void LruReplacer::loaded(int frame, uint64_t page) { accessed(frame); }
+
+void LruReplacer::accessed(int frame)
+{
+    _recency.remove(frame);
+    _recency.pushBack(frame);
+}
+
+void LruReplacer::evicted(int frame) { _recency.remove(frame); }
+
+void LruReplacer::removed(int frame) { _recency.remove(frame); }
+
+int LruReplacer::selectVictim(uint64_t incoming) { return _recency.front(); }
+
+const char* LruReplacer::getName() { return "lru"; }
+
+LfuReplacer::LfuReplacer(uint32_t num_frames) : PageReplacer(num_frames)
+{
+    _count.assign(num_frames, 0);
+    _last_use.assign(num_frames, 0);
+    _clock = 0;
+}
+
+/** Re-files a frame under a new use count, stamped with the current time **/
+void LfuReplacer::touch(int frame, uint64_t count)
+{
+    if (_count[frame] > 0)
+    {
+        _order.erase(std::make_pair(std::make_pair(_count[frame], _last_use[frame]), frame));
+    }
+    _count[frame] = count;
+    _last_use[frame] = ++_clock;
+    _order.insert(std::make_pair(std::make_pair(count, _last_use[frame]), frame));
+}
+
+void LfuReplacer::loaded(int frame, uint64_t page) { touch(frame, 1); }
+
+void LfuReplacer::accessed(int frame) { touch(frame, _count[frame] + 1); }
+
+void LfuReplacer::evicted(int frame) { removed(frame); }
+
+void LfuReplacer::removed(int frame)
+{
+    if (_count[frame] > 0)
+    {
+        _order.erase(std::make_pair(std::make_pair(_count[frame], _last_use[frame]), frame));
+        _count[frame] = 0;
+    }
+}
+
+int LfuReplacer::selectVictim(uint64_t incoming) { return _order.empty() ? -1 : _order.begin()->second; }
+
+const char* LfuReplacer::getName() { return "lfu"; }
+
+ArcReplacer::ArcReplacer(uint32_t num_frames) : PageReplacer(num_frames), _t1(num_frames), _t2(num_frames)
+{
+    _frame_page.assign(num_frames, 0);
+    _p = 0;
+}
+
+/** Drops the oldest page from a ghost list **/
+void ArcReplacer::forget(std::list<uint64_t> &ghosts, std::unordered_map<uint64_t, std::list<uint64_t>::iterator> &pages)
+{
+    pages.erase(ghosts.front());
+    ghosts.pop_front();
+}
+
+void ArcReplacer::loaded(int frame, uint64_t page)
+{
+    _frame_page[frame] = page;
+    std::unordered_map<uint64_t, std::list<uint64_t>::iterator>::iterator ghost;
+
+    if ((ghost = _b1_pages.find(page)) != _b1_pages.end())
+    {
+        // Missed a page T1 gave up too early: give T1 more room
+        _p = std::min<uint32_t>(_num_frames, _p + std::max<uint32_t>(1, _b2.size() / _b1.size()));
+        _b1.erase(ghost->second);
+        _b1_pages.erase(ghost);
+        _t2.pushBack(frame);
+        return;
+    }
+    if ((ghost = _b2_pages.find(page)) != _b2_pages.end())
+    {
+        // Missed a page T2 gave up too early: give T2 more room
+        uint32_t step = std::max<uint32_t>(1, _b1.size() / _b2.size());
+        _p = (_p > step) ? _p - step : 0;
+        _b2.erase(ghost->second);
+        _b2_pages.erase(ghost);
+        _t2.pushBack(frame);
+        return;
+    }
+
+    // A page never seen before: keep T1 plus its ghosts within one cache's worth, and everything within two
+    if (_t1.size() + _b1.size() >= _num_frames && !_b1.empty())
+    {
+        forget(_b1, _b1_pages);
+    }
+    else if (_t1.size() + _t2.size() + _b1.size() + _b2.size() >= 2 * _num_frames && !_b2.empty())
+    {
+        forget(_b2, _b2_pages);
+    }
+    _t1.pushBack(frame);
+}
+
+void ArcReplacer::accessed(int frame)
+{
+    // Any hit makes a page frequent
+    _t1.remove(frame);
+    _t2.remove(frame);
+    _t2.pushBack(frame);
+}
+
+void ArcReplacer::evicted(int frame)
+{
+    uint64_t page = _frame_page[frame];
+    if (_t1.contains(frame)) {
+        _t1.remove(frame);
+        _b1_pages[page] = _b1.insert(_b1.end(), page);
+    } else if (_t2.contains(frame)) {
+        _t2.remove(frame);
+        _b2_pages[page] = _b2.insert(_b2.end(), page);
+    }
+}
+
+void ArcReplacer::removed(int frame)
+{
+    _t1.remove(frame);
+    _t2.remove(frame);
+}
+
+int ArcReplacer::selectVictim(uint64_t incoming)
+{
+    if (_t1.size() > 0 && (_t1.size() > _p || (_t1.size() == _p && _b2_pages.count(incoming) > 0) || _t2.size() == 0))
+    {
+        return _t1.front();
+    }
+    return _t2.front();
+}
+
+const char* ArcReplacer::getName() { return "arc"; }
+
+OptReplacer::OptReplacer(uint32_t num_frames, const std::vector<uint64_t> &trace) : PageReplacer(num_frames)
+{
+    // Walk the trace backwards, remembering where each page is used next
+    _next_use.assign(trace.size(), trace.size());
+    std::unordered_map<uint64_t, uint64_t> next;
+    for (size_t i = trace.size(); i-- > 0;)
+    {
+        std::unordered_map<uint64_t, uint64_t>::iterator it = next.find(trace[i]);
+        if (it != next.end())
+        {
+            _next_use[i] = it->second;
+        }
+        next[trace[i]] = i;
+    }
+    _position = 0;
+    _frame_next.assign(num_frames, 0);
+}
+
+/** Every access (hit or fault) advances the trace by one and re-files the frame under its page's next use **/
+void OptReplacer::touch(int frame)
+{
+    _order.erase(std::make_pair(_frame_next[frame], frame));
+    _frame_next[frame] = (_position < _next_use.size()) ? _next_use[_position] : _next_use.size();
+    _order.insert(std::make_pair(_frame_next[frame], frame));
+    _position++;
+}
+
+void OptReplacer::loaded(int frame, uint64_t page) { touch(frame); }
+
+void OptReplacer::accessed(int frame) { touch(frame); }
+
+void OptReplacer::evicted(int frame) { removed(frame); }
+
+void OptReplacer::removed(int frame) { _order.erase(std::make_pair(_frame_next[frame], frame)); }
+
+int OptReplacer::selectVictim(uint64_t incoming) { return _order.empty() ? -1 : _order.rbegin()->second; }
+
+const char* OptReplacer::getName() { return "opt"; }
+
+PageReplacer* createPageReplacer(ReplacementPolicy policy, uint32_t num_frames)
+{
+    switch (policy)
+    {
+        case ReplacementPolicy::Fifo: return new FifoReplacer(num_frames);
+        case ReplacementPolicy::Lru: return new LruReplacer(num_frames);
+        case ReplacementPolicy::Lfu: return new LfuReplacer(num_frames);
+        case ReplacementPolicy::Arc: return new ArcReplacer(num_frames);
+        case ReplacementPolicy::Clock:
+        default: return new ClockReplacer(num_frames);
+    }
+}
+
+/** Converts a replacement policy name given on the command line into a ReplacementPolicy **/
+bool parseReplacementPolicy(std::string name, ReplacementPolicy *policy)
+{
+    if (name == "clock") { *policy = ReplacementPolicy::Clock; }
+    else if (name == "fifo") { *policy = ReplacementPolicy::Fifo; }
+    else if (name == "lru") { *policy = ReplacementPolicy::Lru; }
+    else if (name == "lfu") { *policy = ReplacementPolicy::Lfu; }
+    else if (name == "arc") { *policy = ReplacementPolicy::Arc; }
+    else { return false; }
+    return true;
+}
+
+const char* replacementPolicyName(ReplacementPolicy policy)
+{
+    const char *names[] = {"clock", "fifo", "lru", "lfu", "arc"};
+    return names[policy];
+}
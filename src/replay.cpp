@@ -0,0 +1,388 @@
+#include "replay.h"
+#include <iostream>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+// Segments smaller than this, or with only one PID in them, run serially: waking the pool would cost more than it saves
+static const size_t MIN_PARALLEL_SEGMENT = 64;
+
+ParallelReplay::ParallelReplay(Simulator *sim, int num_threads)
+{
+    _sim = sim;
+    _num_workers = std::max(1, num_threads);
+    _next_pid = 0;
+    _remaining.store(0);
+    _next_rank = 0;
+    _pushes.store(0);
+    _generation = 0;
+    _running = 0;
+    _stopping = false;
+
+    for (int i = 0; i < _num_workers; i++)
+    {
+        _buffers.push_back(std::unique_ptr<std::ostringstream>(new std::ostringstream()));
+        _queues.push_back(std::unique_ptr<ReplayQueue>(new ReplayQueue()));
+        _workers.push_back(*sim);
+        _workers[i].out = _buffers[i].get();
+    }
+
+    // The calling thread is worker 0, so it only needs helpers for the rest
+    for (int i = 1; i < _num_workers; i++)
+    {
+        _threads.push_back(std::thread(&ParallelReplay::workerLoop, this, i));
+    }
+}
+
+ParallelReplay::~ParallelReplay()
+{
+    {
+        std::lock_guard<std::mutex> guard(_pool_lock);
+        _stopping = true;
+    }
+    _start.notify_all();
+    for (size_t i = 0; i < _threads.size(); i++)
+    {
+        _threads[i].join();
+    }
+}
+
+/** A TLB or a page replacer sees every access from every process, so their state depends on the global interleaving
+    and a parallel replay can't reproduce it **/
+bool ParallelReplay::supports(Simulator *sim)
+{
+    return sim->tlb == NULL && !sim->page_table->isDemandPaging();
+}
+
+/** Queues one command line, running the window once it is full **/
+void ParallelReplay::submit(const std::string &line)
+{
+    // Everything submitted so far has run, so the MMU knows which PID the window's first create will get
+    if (_commands.empty())
+    {
+        _next_pid = _sim->mmu->getNextPid();
+    }
+
+    ReplayCommand command;
+    command.offset = _text.size();
+    command.length = line.size();
+    _text.append(line);
+    bool renumbers = classify(command);
+    _commands.push_back(command);
+    // After a command that replaces the process table, later creates can only be numbered once it has run
+    if (_commands.size() >= WINDOW_SIZE || renumbers)
+    {
+        runWindow();
+    }
+}
+
+/** Runs whatever is still buffered **/
+void ParallelReplay::finish()
+{
+    if (!_commands.empty())
+    {
+        runWindow();
+    }
+    std::cout.flush();
+}
+
+/** Works out a command's PID and how it has to be ordered. Anything that doesn't parse is a barrier, which is always safe.
+    Returns true for "load", which changes which PIDs the following creates get **/
+bool ParallelReplay::classify(ReplayCommand &command)
+{
+    command.kind = ReplayBarrier;
+    command.pid = 0;
+    command.rank = 0;
+
+    size_t count = tokenize(_text.data() + command.offset, command.length, ' ', _tokens);
+    if (count == 0)
+    {
+        return false;
+    }
+    const Token *args = &_tokens[0];
+    uint32_t text_size, data_size;
+
+    if (tokenEquals(args[0], "create"))
+    {
+        // PIDs are handed out in order, so the create's PID is known before it runs
+        if (count >= 3 && parseUInt32(args[1], &text_size) && parseUInt32(args[2], &data_size))
+        {
+            command.kind = ReplayOrdered;
+            command.pid = _next_pid++;
+        }
+    }
+    else if ((tokenEquals(args[0], "allocate") && count >= 5) || (tokenEquals(args[0], "free") && count >= 3) ||
+        (tokenEquals(args[0], "terminate") && count >= 2))
+    {
+        if (parseUInt32(args[1], &command.pid))
+        {
+            command.kind = ReplayOrdered;
+        }
+    }
+    else if (tokenEquals(args[0], "set") && count >= 4)
+    {
+        if (parseUInt32(args[1], &command.pid))
+        {
+            command.kind = ReplayLocal;
+        }
+    }
+    else if ((tokenEquals(args[0], "print") || tokenEquals(args[0], "dump")) && count >= 2)
+    {
+        // Only "<PID>:<var_name>" is local; "print mmu" and friends look at the whole machine
+        const char *colon = (const char*)memchr(args[1].data, ':', args[1].length);
+        if (colon != NULL)
+        {
+            Token pid_token = {args[1].data, (size_t)(colon - args[1].data)};
+            if (parseUInt32(pid_token, &command.pid))
+            {
+                command.kind = ReplayLocal;
+            }
+        }
+    }
+    else if (tokenEquals(args[0], "load"))
+    {
+        return true;
+    }
+    return false;
+}
+
+/** Runs the buffered window: each stretch between barriers as a parallel segment, each barrier on its own **/
+void ParallelReplay::runWindow()
+{
+    _outputs.resize(_commands.size());
+    size_t begin = 0;
+    for (size_t i = 0; i <= _commands.size(); i++)
+    {
+        if (i < _commands.size() && _commands[i].kind != ReplayBarrier)
+        {
+            continue;
+        }
+        runSegment(begin, i);
+        if (i < _commands.size())
+        {
+            run(_sim, (uint32_t)i);
+        }
+        begin = i + 1;
+    }
+    _commands.clear();
+    _text.clear();
+}
+
+/** Runs commands [begin, end), none of them barriers, and prints their output in script order **/
+void ParallelReplay::runSegment(size_t begin, size_t end)
+{
+    if (begin == end)
+    {
+        return;
+    }
+
+    // One partition per PID, in script order; ordered commands are ranked across all of them
+    _partitions.clear();
+    std::unordered_map<uint32_t, uint32_t> partition_of;
+    uint32_t num_ranks = 0;
+    for (size_t i = begin; i < end; i++)
+    {
+        ReplayCommand &command = _commands[i];
+        if (command.kind == ReplayOrdered)
+        {
+            command.rank = num_ranks++;
+        }
+        std::pair<std::unordered_map<uint32_t, uint32_t>::iterator, bool> found =
+            partition_of.insert(std::make_pair(command.pid, (uint32_t)_partitions.size()));
+        if (found.second)
+        {
+            _partitions.push_back(ReplayPartition());
+            _partitions.back().next = 0;
+        }
+        _partitions[found.first->second].commands.push_back((uint32_t)i);
+    }
+
+    if (_num_workers < 2 || _partitions.size() < 2 || end - begin < MIN_PARALLEL_SEGMENT)
+    {
+        for (size_t i = begin; i < end; i++)
+        {
+            run(_sim, (uint32_t)i);
+        }
+        return;
+    }
+
+    for (int i = 0; i < _num_workers; i++)
+    {
+        _buffers[i]->str(std::string());
+        _buffers[i]->clear();
+    }
+    for (size_t i = 0; i < _partitions.size(); i++)
+    {
+        _queues[i % _num_workers]->partitions.push_back((uint32_t)i);
+    }
+    _parked.assign(num_ranks, -1);
+    _next_rank = 0;
+    _remaining.store(_partitions.size());
+
+    // Wake the helpers, pitch in, then wait for the stragglers
+    {
+        std::lock_guard<std::mutex> guard(_pool_lock);
+        _generation++;
+        _running = _num_workers - 1;
+    }
+    _start.notify_all();
+    work(0);
+    {
+        std::unique_lock<std::mutex> lock(_pool_lock);
+        _finished.wait(lock, [this] { return _running == 0; });
+    }
+
+    std::vector<std::string> text(_num_workers);
+    for (int i = 0; i < _num_workers; i++)
+    {
+        text[i] = _buffers[i]->str();
+    }
+    for (size_t i = begin; i < end; i++)
+    {
+        const ReplayOutput &output = _outputs[i];
+        std::cout.write(text[output.worker].data() + output.offset, output.length);
+    }
+}
+
+/** Helper thread: sits idle until a segment starts, works on it, reports back **/
+void ParallelReplay::workerLoop(int worker)
+{
+    uint64_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_pool_lock);
+            _start.wait(lock, [this, seen] { return _stopping || _generation != seen; });
+            if (_stopping)
+            {
+                return;
+            }
+            seen = _generation;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> guard(_pool_lock);
+            if (--_running == 0)
+            {
+                _finished.notify_one();
+            }
+        }
+    }
+}
+
+/** Runs partitions until every one in the segment is finished **/
+void ParallelReplay::work(int worker)
+{
+    uint32_t partition;
+    while (_remaining.load() > 0)
+    {
+        uint64_t pushes = _pushes.load();
+        if (takePartition(worker, &partition))
+        {
+            runPartition(worker, partition);
+            continue;
+        }
+
+        // Nothing to take: sleep until a parked partition is put back or the segment ends, rather than spinning
+        // on a core another worker could be using
+        std::unique_lock<std::mutex> lock(_idle_lock);
+        _idle.wait(lock, [this, pushes] { return _pushes.load() != pushes || _remaining.load() == 0; });
+    }
+}
+
+/** Takes the newest partition from the worker's own queue, or steals the oldest one from another worker **/
+bool ParallelReplay::takePartition(int worker, uint32_t *partition)
+{
+    for (int i = 0; i < _num_workers; i++)
+    {
+        ReplayQueue &queue = *_queues[(worker + i) % _num_workers];
+        std::lock_guard<std::mutex> guard(queue.lock);
+        if (queue.partitions.empty())
+        {
+            continue;
+        }
+        if (i == 0) {
+            *partition = queue.partitions.back();
+            queue.partitions.pop_back();
+        } else {
+            *partition = queue.partitions.front();
+            queue.partitions.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+/** Runs a partition's commands in order until it is done, or until it reaches an ordered command whose turn hasn't
+    come yet; then it is parked, and whoever runs the command before it puts it back in a queue **/
+void ParallelReplay::runPartition(int worker, uint32_t partition)
+{
+    ReplayPartition &part = _partitions[partition];
+    while (part.next < part.commands.size())
+    {
+        uint32_t index = part.commands[part.next];
+        const ReplayCommand &command = _commands[index];
+        if (command.kind == ReplayOrdered)
+        {
+            std::lock_guard<std::mutex> guard(_order_lock);
+            if (command.rank != _next_rank)
+            {
+                _parked[command.rank] = partition;
+                return;
+            }
+        }
+
+        execute(worker, index);
+        part.next++;
+
+        if (command.kind == ReplayOrdered)
+        {
+            bool requeued = false;
+            {
+                std::lock_guard<std::mutex> guard(_order_lock);
+                _next_rank++;
+                if (_next_rank < _parked.size() && _parked[_next_rank] >= 0)
+                {
+                    ReplayQueue &queue = *_queues[worker];
+                    std::lock_guard<std::mutex> queue_guard(queue.lock);
+                    queue.partitions.push_back((uint32_t)_parked[_next_rank]);
+                    _parked[_next_rank] = -1;
+                    requeued = true;
+                }
+            }
+            if (requeued)
+            {
+                {
+                    std::lock_guard<std::mutex> guard(_idle_lock);
+                    _pushes++;
+                }
+                _idle.notify_one();
+            }
+        }
+    }
+
+    if (--_remaining == 0)
+    {
+        {
+            std::lock_guard<std::mutex> guard(_idle_lock);
+        }
+        _idle.notify_all();
+    }
+}
+
+/** Runs one buffered command on the given simulator **/
+void ParallelReplay::run(Simulator *sim, uint32_t index)
+{
+    executeCommand(sim, _text.data() + _commands[index].offset, _commands[index].length);
+}
+
+/** Runs one command on a worker's simulator, remembering where its output went **/
+void ParallelReplay::execute(int worker, uint32_t index)
+{
+    std::ostringstream &buffer = *_buffers[worker];
+    ReplayOutput &output = _outputs[index];
+    output.worker = worker;
+    output.offset = (size_t)buffer.tellp();
+    run(&_workers[worker], (uint32_t)index);
+    output.length = (size_t)buffer.tellp() - output.offset;
+}
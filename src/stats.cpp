@@ -0,0 +1,217 @@
+#include "stats.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+
+static const char *stat_names[NUM_STAT_OPS] = {"parse", "lookup", "allocate", "map", "translate", "free", "terminate"};
+// Only one in this many operations is timed; the rest are just counted. Lookups and translations take about as long
+// as reading the clock twice, so timing every one of them would mostly measure the clock
+static const uint64_t sample_periods[NUM_STAT_OPS] = {1, 16, 1, 1, 16, 1, 1};
+
+/** Every thread's block, kept after the thread exits so its counts still show up **/
+static std::mutex registry_lock;
+static std::vector<std::unique_ptr<StatBlock> > registry;
+
+static StatBlock* localBlock()
+{
+    static thread_local StatBlock *block = NULL;
+    if (block == NULL)
+    {
+        std::unique_ptr<StatBlock> created(new StatBlock());
+        for (int op = 0; op < NUM_STAT_OPS; op++)
+        {
+            created->counts[op].store(0);
+            StatHistogram &histogram = created->histograms[op];
+            histogram.samples.store(0);
+            histogram.total_ns.store(0);
+            histogram.max_ns.store(0);
+            for (int i = 0; i < NUM_STAT_BUCKETS; i++) { histogram.buckets[i].store(0); }
+        }
+        block = created.get();
+        std::lock_guard<std::mutex> guard(registry_lock);
+        registry.push_back(std::move(created));
+    }
+    return block;
+}
+
+/** Adds to a counter only this thread writes **/
+static inline void bump(std::atomic<uint64_t> &counter, uint64_t amount)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+bool statsEnabled()
+{
+#ifdef MEMSIM_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/** Counts an operation; returns true if this one should be timed **/
+bool statsCount(StatOp op)
+{
+    std::atomic<uint64_t> &count = localBlock()->counts[op];
+    uint64_t seen = count.load(std::memory_order_relaxed);
+    count.store(seen + 1, std::memory_order_relaxed);
+    return seen % sample_periods[op] == 0;
+}
+
+/** Counts and records an operation the caller has already timed **/
+void statsRecord(StatOp op, uint64_t ns)
+{
+    bump(localBlock()->counts[op], 1);
+    statsRecordTime(op, ns);
+}
+
+void statsRecordTime(StatOp op, uint64_t ns)
+{
+    StatHistogram &histogram = localBlock()->histograms[op];
+    int bucket = (ns == 0) ? 0 : 63 - __builtin_clzll(ns);
+    if (bucket >= NUM_STAT_BUCKETS) { bucket = NUM_STAT_BUCKETS - 1; }
+    bump(histogram.samples, 1);
+    bump(histogram.total_ns, ns);
+    bump(histogram.buckets[bucket], 1);
+    if (ns > histogram.max_ns.load(std::memory_order_relaxed))
+    {
+        histogram.max_ns.store(ns, std::memory_order_relaxed);
+    }
+}
+
+/** All threads' counts for one operation, added up **/
+typedef struct StatTotals {
+    uint64_t count;
+    uint64_t samples;
+    uint64_t total_ns;
+    uint64_t max_ns;
+    uint64_t buckets[NUM_STAT_BUCKETS];
+} StatTotals;
+
+static void collect(StatTotals *totals)
+{
+    for (int op = 0; op < NUM_STAT_OPS; op++)
+    {
+        totals[op] = StatTotals();
+    }
+    std::lock_guard<std::mutex> guard(registry_lock);
+    for (size_t b = 0; b < registry.size(); b++)
+    {
+        StatBlock &block = *registry[b];
+        for (int op = 0; op < NUM_STAT_OPS; op++)
+        {
+            StatHistogram &histogram = block.histograms[op];
+            totals[op].count += block.counts[op].load(std::memory_order_relaxed);
+            totals[op].samples += histogram.samples.load(std::memory_order_relaxed);
+            totals[op].total_ns += histogram.total_ns.load(std::memory_order_relaxed);
+            uint64_t max_ns = histogram.max_ns.load(std::memory_order_relaxed);
+            if (max_ns > totals[op].max_ns) { totals[op].max_ns = max_ns; }
+            for (int i = 0; i < NUM_STAT_BUCKETS; i++)
+            {
+                totals[op].buckets[i] += histogram.buckets[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+/** Upper bound of the bucket holding the given share of the samples **/
+static uint64_t percentile(const StatTotals &totals, double share)
+{
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_STAT_BUCKETS; i++)
+    {
+        seen += totals.buckets[i];
+        if (seen > 0 && seen >= share * totals.samples)
+        {
+            return 2ULL << i;
+        }
+    }
+    return 0;
+}
+
+/** Prints each operation's count and latency summary, then its histogram **/
+void printStats()
+{
+    if (!statsEnabled())
+    {
+        printf("Statistics are compiled out; rebuild with make STATS=1\n");
+        return;
+    }
+
+    StatTotals totals[NUM_STAT_OPS];
+    collect(totals);
+    printf(" Operation |      Count |      Timed |  Avg (ns) | p50 (ns) | p99 (ns) |   Max (ns)\n");
+    printf("-----------+------------+------------+-----------+----------+----------+------------\n");
+    for (int op = 0; op < NUM_STAT_OPS; op++)
+    {
+        const StatTotals &t = totals[op];
+        printf(" %-9s | %10llu | %10llu | %9.1f | %8llu | %8llu | %10llu\n", stat_names[op], (unsigned long long)t.count,
+            (unsigned long long)t.samples, t.samples > 0 ? (double)t.total_ns / t.samples : 0.0,
+            (unsigned long long)percentile(t, 0.5), (unsigned long long)percentile(t, 0.99), (unsigned long long)t.max_ns);
+    }
+
+    // Percentiles are bucket upper bounds, so the histograms show how the samples actually spread out
+    printf("\nLatency histograms (samples per power-of-two bucket, labelled by upper bound in ns):\n");
+    for (int op = 0; op < NUM_STAT_OPS; op++)
+    {
+        if (totals[op].samples == 0)
+        {
+            continue;
+        }
+        printf(" %-9s |", stat_names[op]);
+        for (int i = 0; i < NUM_STAT_BUCKETS; i++)
+        {
+            if (totals[op].buckets[i] > 0)
+            {
+                printf(" <%llu: %llu", (unsigned long long)(2ULL << i), (unsigned long long)totals[op].buckets[i]);
+            }
+        }
+        printf("\n");
+    }
+}
+
+/** Writes every counter and histogram to path, as CSV if it ends in ".csv" and JSON otherwise **/
+bool writeStats(const std::string &path)
+{
+    FILE *file = fopen(path.c_str(), "w");
+    if (file == NULL)
+    {
+        return false;
+    }
+
+    StatTotals totals[NUM_STAT_OPS];
+    collect(totals);
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    if (csv)
+    {
+        // One row per operation; bucket columns are named by their upper bound in ns
+        fprintf(file, "operation,count,timed,total_ns,max_ns");
+        for (int i = 0; i < NUM_STAT_BUCKETS; i++) { fprintf(file, ",lt_%llu", (unsigned long long)(2ULL << i)); }
+        fprintf(file, "\n");
+        for (int op = 0; op < NUM_STAT_OPS; op++)
+        {
+            const StatTotals &t = totals[op];
+            fprintf(file, "%s,%llu,%llu,%llu,%llu", stat_names[op], (unsigned long long)t.count, (unsigned long long)t.samples,
+                (unsigned long long)t.total_ns, (unsigned long long)t.max_ns);
+            for (int i = 0; i < NUM_STAT_BUCKETS; i++) { fprintf(file, ",%llu", (unsigned long long)t.buckets[i]); }
+            fprintf(file, "\n");
+        }
+    }
+    else
+    {
+        // buckets[k] counts latencies in [2^k, 2^(k+1)) ns
+        fprintf(file, "{\n  \"enabled\": %s,\n  \"operations\": {\n", statsEnabled() ? "true" : "false");
+        for (int op = 0; op < NUM_STAT_OPS; op++)
+        {
+            const StatTotals &t = totals[op];
+            fprintf(file, "    \"%s\": {\"count\": %llu, \"timed\": %llu, \"total_ns\": %llu, \"max_ns\": %llu, \"buckets\": [",
+                stat_names[op], (unsigned long long)t.count, (unsigned long long)t.samples, (unsigned long long)t.total_ns,
+                (unsigned long long)t.max_ns);
+            for (int i = 0; i < NUM_STAT_BUCKETS; i++) { fprintf(file, i > 0 ? ", %llu" : "%llu", (unsigned long long)t.buckets[i]); }
+            fprintf(file, "]}%s\n", op + 1 < NUM_STAT_OPS ? "," : "");
+        }
+        fprintf(file, "  }\n}\n");
+    }
+    return fclose(file) == 0;
+}
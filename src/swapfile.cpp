@@ -0,0 +1,50 @@
+#include "swapfile.h"
+#include <fcntl.h>
+#include <unistd.h>
+
+SwapFile::SwapFile(const std::string &path, uint32_t num_slots, uint32_t slot_size) : _slots(num_slots)
+{
+    _slot_size = slot_size;
+    _fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (_fd < 0)
+    {
+        return;
+    }
+
+    // The file only lives as long as the simulator, so unlink it right away; sizing it up front keeps it sparse
+    unlink(path.c_str());
+    if (ftruncate(_fd, (off_t)num_slots * slot_size) != 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+}
+
+SwapFile::~SwapFile()
+{
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+}
+
+bool SwapFile::isOpen(){ return _fd >= 0; }
+
+/** Reserves a free slot, returns -1 if swap is full **/
+int SwapFile::allocate() { return _slots.allocate(); }
+
+void SwapFile::release(int slot) { _slots.release(slot); }
+
+bool SwapFile::write(int slot, const uint8_t *page)
+{
+    return pwrite(_fd, page, _slot_size, (off_t)slot * _slot_size) == (ssize_t)_slot_size;
+}
+
+bool SwapFile::read(int slot, uint8_t *page)
+{
+    return pread(_fd, page, _slot_size, (off_t)slot * _slot_size) == (ssize_t)_slot_size;
+}
+
+uint32_t SwapFile::getNumSlots(){ return _slots.getNumFrames(); }
+
+uint32_t SwapFile::getFreeSlots(){ return _slots.getFreeFrames(); }
@@ -0,0 +1,180 @@
+#include "tlb.h"
+
+Tlb::Tlb(TlbConfig config)
+{
+    // Associativity can't exceed the number of entries, and every set has the same number of ways
+    if (config.entries == 0) { config.entries = 1; }
+    if (config.ways == 0 || config.ways > config.entries) { config.ways = config.entries; }
+    config.entries = config.entries - (config.entries % config.ways);
+
+    _config = config;
+    _num_sets = config.entries / config.ways;
+    _entries.assign(config.entries, TlbEntry());
+    _clock = 0;
+    _random_state = 0x9E3779B97F4A7C15ULL;
+    _current_pid = 0;
+
+    _hits = 0;
+    _misses = 0;
+    _evictions = 0;
+    _invalidations = 0;
+    _flushes = 0;
+}
+
+Tlb::~Tlb()
+{
+}
+
+/** Returns the first way of the set that (pid, page) maps to **/
+TlbEntry* Tlb::set(uint32_t pid, uint32_t page)
+{
+    uint64_t hash = ((uint64_t)pid * 0x9E3779B1u) ^ page;
+    return &_entries[(hash % _num_sets) * _config.ways];
+}
+
+/** Looks up a translation, returns true and sets frame on a hit **/
+bool Tlb::lookup(uint32_t pid, uint32_t page, int *frame)
+{
+    // Without ASID tags, switching to another process invalidates everything cached for the last one
+    if (!_config.asid_tagging && pid != _current_pid)
+    {
+        // PID 0 is never handed out, so there's nothing to flush before the first lookup
+        if (_current_pid != 0) { flush(); }
+        _current_pid = pid;
+    }
+
+    TlbEntry *ways = set(pid, page);
+    for (uint32_t i = 0; i < _config.ways; i++)
+    {
+        if (ways[i].valid && ways[i].pid == pid && ways[i].page == page)
+        {
+            if (_config.policy == TlbPolicy::TlbLru)
+            {
+                ways[i].stamp = ++_clock;
+            }
+            *frame = ways[i].frame;
+            _hits++;
+            return true;
+        }
+    }
+
+    _misses++;
+    return false;
+}
+
+/** Caches a translation, evicting a way of its set chosen by the replacement policy if the set is full **/
+void Tlb::insert(uint32_t pid, uint32_t page, int frame)
+{
+    TlbEntry *ways = set(pid, page);
+    TlbEntry *victim = NULL;
+
+    for (uint32_t i = 0; i < _config.ways; i++)
+    {
+        if (!ways[i].valid)
+        {
+            victim = &ways[i];
+            break;
+        }
+    }
+
+    if (victim == NULL)
+    {
+        if (_config.policy == TlbPolicy::TlbRandom)
+        {
+            // xorshift64
+            _random_state ^= _random_state << 13;
+            _random_state ^= _random_state >> 7;
+            _random_state ^= _random_state << 17;
+            victim = &ways[_random_state % _config.ways];
+        }
+        else
+        {
+            // LRU and FIFO both evict the oldest stamp; only LRU refreshes it on a hit
+            victim = &ways[0];
+            for (uint32_t i = 1; i < _config.ways; i++)
+            {
+                if (ways[i].stamp < victim->stamp)
+                {
+                    victim = &ways[i];
+                }
+            }
+        }
+        _evictions++;
+    }
+
+    victim->valid = true;
+    victim->pid = pid;
+    victim->page = page;
+    victim->frame = frame;
+    victim->stamp = ++_clock;
+}
+
+/** Drops the cached translation of a single page, if there is one **/
+void Tlb::invalidate(uint32_t pid, uint32_t page)
+{
+    TlbEntry *ways = set(pid, page);
+    for (uint32_t i = 0; i < _config.ways; i++)
+    {
+        if (ways[i].valid && ways[i].pid == pid && ways[i].page == page)
+        {
+            ways[i].valid = false;
+            _invalidations++;
+        }
+    }
+}
+
+/** Drops every cached translation that belongs to a process **/
+void Tlb::invalidateProcess(uint32_t pid)
+{
+    for (size_t i = 0; i < _entries.size(); i++)
+    {
+        if (_entries[i].valid && _entries[i].pid == pid)
+        {
+            _entries[i].valid = false;
+            _invalidations++;
+        }
+    }
+}
+
+void Tlb::flush()
+{
+    for (size_t i = 0; i < _entries.size(); i++)
+    {
+        _entries[i].valid = false;
+    }
+    _flushes++;
+}
+
+/** Prints the TLB geometry and its hit/miss statistics **/
+void Tlb::print(int page_size)
+{
+    const char *policies[] = {"lru", "fifo", "random"};
+    uint64_t lookups = _hits + _misses;
+    double hit_rate = (lookups > 0) ? (100.0 * _hits / lookups) : 0.0;
+
+    printf("TLB: %u entries, %u-way, %s, %s\n", _config.entries, _config.ways, policies[_config.policy],
+        _config.asid_tagging ? "ASID tagged" : "flush on switch");
+    printf("  reach:         %llu bytes\n", (unsigned long long)_config.entries * page_size);
+    printf("  lookups:       %llu\n", (unsigned long long)lookups);
+    printf("  hits:          %llu (%.2f%%)\n", (unsigned long long)_hits, hit_rate);
+    printf("  misses:        %llu\n", (unsigned long long)_misses);
+    printf("  evictions:     %llu\n", (unsigned long long)_evictions);
+    printf("  invalidations: %llu\n", (unsigned long long)_invalidations);
+    printf("  flushes:       %llu\n", (unsigned long long)_flushes);
+}
+
+uint64_t Tlb::getHits(){ return _hits; }
+
+uint64_t Tlb::getMisses(){ return _misses; }
+
+uint64_t Tlb::getEvictions(){ return _evictions; }
+
+/** Converts a policy name given on the command line into a TlbPolicy **/
+bool parseTlbPolicy(std::string name, TlbPolicy *policy)
+{
+    if (name == "lru") { *policy = TlbPolicy::TlbLru; }
+    else if (name == "fifo") { *policy = TlbPolicy::TlbFifo; }
+    else if (name == "random") { *policy = TlbPolicy::TlbRandom; }
+    else { return false; }
+    return true;
+}
@@ -0,0 +1,668 @@
+/** Generates synthetic command traces for memsim: processes that come and go, variables whose sizes follow a
+    distribution per data type, Zipf-distributed accesses, free patterns that fragment the heap, and phases that
+    change the mix of operations over time. The same seed and options always give the same trace, and it is written
+    as it is generated, so traces of any length take memory only for the processes and variables alive at the time **/
+#include <string>
+#include <vector>
+#include <queue>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cstdarg>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <cstdint>
+
+enum TraceType {TypeChar, TypeShort, TypeInt, TypeLong, TypeFloat, TypeDouble, NUM_TYPES};
+static const char *type_names[NUM_TYPES] = {"char", "short", "int", "long", "float", "double"};
+static const uint32_t type_sizes[NUM_TYPES] = {1, 2, 4, 8, 4, 8};
+
+enum SizeShape {SizeFixed, SizeUniform, SizeLognormal, SizePareto};
+
+/** How many elements a variable of one type gets **/
+typedef struct SizeDistribution {
+    SizeShape shape;
+    double a;   // fixed: count; uniform: min; lognormal: median; pareto: minimum
+    double b;   // uniform: max; lognormal: sigma; pareto: alpha (smaller means a heavier tail)
+} SizeDistribution;
+
+enum TraceOp {OpAllocate, OpFree, OpSet, OpPrint, NUM_OPS};
+
+/** A stretch of the trace with its own mix of operations **/
+typedef struct Phase {
+    const char *name;
+    double weights[NUM_OPS];
+} Phase;
+
+static const Phase known_phases[] = {
+    {"grow",   {60, 10, 20, 10}},
+    {"steady", {10, 10, 50, 30}},
+    {"churn",  {45, 45,  5,  5}},
+    {"shrink", {10, 60, 20, 10}}
+};
+
+enum FreePattern {FreeRandom, FreeFifo, FreeLifo, FreeCheckerboard};
+
+typedef struct TraceVariable {
+    uint32_t name;
+    TraceType type;
+    uint32_t elements;
+} TraceVariable;
+
+typedef struct TraceProcess {
+    uint32_t pid;
+    uint64_t bytes;
+    uint32_t next_name;
+    // Live variables in allocation order; the newest is the most likely to be accessed
+    std::vector<TraceVariable> variables;
+} TraceProcess;
+
+/** Zipf-distributed ranks in [1, n] by rejection-inversion (Hormann and Derflinger), which needs no table, so n can
+    change from one draw to the next **/
+class ZipfSampler {
+private:
+    double _exponent;
+
+    static double helper1(double x) { return fabs(x) > 1e-8 ? log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x)); }
+    static double helper2(double x) { return fabs(x) > 1e-8 ? expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x / 3.0 * (1.0 + 0.25 * x)); }
+    double h(double x) { return exp(-_exponent * log(x)); }
+    double hIntegral(double x) { double log_x = log(x); return helper2((1.0 - _exponent) * log_x) * log_x; }
+    double hIntegralInverse(double x)
+    {
+        double t = x * (1.0 - _exponent);
+        if (t < -1.0) { t = -1.0; }
+        return exp(helper1(t) * x);
+    }
+
+public:
+    ZipfSampler(double exponent) : _exponent(exponent) {}
+
+    uint32_t sample(uint32_t n, std::mt19937_64 &rng)
+    {
+        if (n <= 1 || _exponent <= 0.0)
+        {
+            return n <= 1 ? 1 : 1 + (uint32_t)(rng() % n);
+        }
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        double integral_x1 = hIntegral(1.5) - 1.0;
+        double integral_n = hIntegral(n + 0.5);
+        double s = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+        while (true)
+        {
+            double u = integral_n + unit(rng) * (integral_x1 - integral_n);
+            double x = hIntegralInverse(u);
+            double k = floor(x + 0.5);
+            if (k < 1.0) { k = 1.0; } else if (k > n) { k = n; }
+            if (k - x <= s || u >= hIntegral(k + 0.5) - h(k))
+            {
+                return (uint32_t)k;
+            }
+        }
+    }
+};
+
+/** Generator settings, all of which go into the trace's header comment **/
+typedef struct TraceConfig {
+    uint64_t seed;
+    uint64_t commands;          // stop after this many commands...
+    uint64_t bytes;             // ...or this many bytes of output, whichever comes first (0: no byte limit)
+    uint32_t max_processes;     // processes alive at once
+    uint32_t max_variables;     // live variables per process
+    double lifetime;            // mean commands a process lives for (0: until the end)
+    double zipf;                // exponent of the variable access distribution (0: uniform)
+    uint64_t memory;            // memory of the machine the trace is meant for
+    double fill;                // share of memory live variables may take up, so allocations don't start failing
+    uint32_t first_pid;
+    uint32_t max_elements;
+    FreePattern free_pattern;
+    std::vector<uint32_t> phases;
+    uint64_t phase_length;
+    double type_weights[NUM_TYPES];
+    SizeDistribution sizes[NUM_TYPES];
+    bool terminate_all;         // terminate every live process at the end
+} TraceConfig;
+
+/** Buffers output and counts the bytes written **/
+class TraceWriter {
+private:
+    FILE *_file;
+    std::vector<char> _buffer;
+    size_t _used;
+    uint64_t _written;
+
+public:
+    TraceWriter(FILE *file) : _file(file), _buffer(1 << 20), _used(0), _written(0) {}
+    ~TraceWriter() { flush(); }
+
+    void line(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        if (_buffer.size() - _used < 4096)
+        {
+            flush();
+        }
+        va_list args;
+        va_start(args, format);
+        size_t room = _buffer.size() - _used - 1;
+        size_t length = std::min<size_t>(std::max(0, vsnprintf(&_buffer[_used], room, format, args)), room - 1);
+        va_end(args);
+        _used += length;
+        _buffer[_used++] = '\n';
+        _written += length + 1;
+    }
+
+    void flush()
+    {
+        fwrite(_buffer.data(), 1, _used, _file);
+        _used = 0;
+    }
+
+    uint64_t getWritten() { return _written; }
+};
+
+class TraceGenerator {
+private:
+    const TraceConfig &_config;
+    std::mt19937_64 _rng;
+    ZipfSampler _zipf;
+    TraceWriter &_out;
+    std::vector<TraceProcess> _processes;
+    // (time of death, pid) for every process with a finite lifetime, soonest first
+    std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t> >, std::greater<std::pair<uint64_t, uint32_t> > > _deaths;
+    uint32_t _next_pid;
+    uint64_t _live_bytes;
+    uint64_t _commands;
+
+    double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(_rng); }
+    size_t pick(const double *weights, size_t count);
+    uint32_t sampleElements(TraceType type);
+    size_t findProcess(uint32_t pid);
+    void create();
+    void terminate(size_t index);
+    bool allocate(TraceProcess &proc);
+    void release(TraceProcess &proc);
+    void set(TraceProcess &proc, const TraceVariable &var);
+    const TraceVariable& accessed(TraceProcess &proc);
+
+public:
+    TraceGenerator(const TraceConfig &config, TraceWriter &out);
+    void run();
+};
+
+TraceGenerator::TraceGenerator(const TraceConfig &config, TraceWriter &out) : _config(config), _rng(config.seed), _zipf(config.zipf), _out(out)
+{
+    _next_pid = config.first_pid;
+    _live_bytes = 0;
+    _commands = 0;
+}
+
+/** Index drawn with probability proportional to its weight **/
+size_t TraceGenerator::pick(const double *weights, size_t count)
+{
+    double total = 0.0;
+    for (size_t i = 0; i < count; i++) { total += weights[i]; }
+    double roll = uniform() * total;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (roll < weights[i]) { return i; }
+        roll -= weights[i];
+    }
+    return count - 1;
+}
+
+uint32_t TraceGenerator::sampleElements(TraceType type)
+{
+    const SizeDistribution &size = _config.sizes[type];
+    double elements;
+    switch (size.shape)
+    {
+        case SizeUniform: elements = size.a + floor(uniform() * (size.b - size.a + 1)); break;
+        case SizeLognormal: elements = std::lognormal_distribution<double>(log(size.a), size.b)(_rng); break;
+        case SizePareto: elements = size.a / pow(1.0 - uniform(), 1.0 / size.b); break;
+        case SizeFixed:
+        default: elements = size.a; break;
+    }
+    return (uint32_t)std::max(1.0, std::min((double)_config.max_elements, floor(elements)));
+}
+
+size_t TraceGenerator::findProcess(uint32_t pid)
+{
+    for (size_t i = 0; i < _processes.size(); i++)
+    {
+        if (_processes[i].pid == pid) { return i; }
+    }
+    return _processes.size();
+}
+
+void TraceGenerator::create()
+{
+    uint32_t text = 1024 + (uint32_t)(_rng() % 15361);
+    uint32_t data = 512 + (uint32_t)(_rng() % 7681);
+    uint64_t bytes = text + data + 65536;
+    if (_live_bytes + bytes > _config.memory * _config.fill)
+    {
+        return;
+    }
+    _out.line("create %u %u", text, data);
+    _commands++;
+
+    TraceProcess proc;
+    proc.pid = _next_pid++;
+    proc.bytes = bytes;
+    proc.next_name = 0;
+    _processes.push_back(proc);
+    _live_bytes += bytes;
+    if (_config.lifetime > 0)
+    {
+        uint64_t lifetime = 1 + (uint64_t)std::exponential_distribution<double>(1.0 / _config.lifetime)(_rng);
+        _deaths.push(std::make_pair(_commands + lifetime, proc.pid));
+    }
+}
+
+void TraceGenerator::terminate(size_t index)
+{
+    _out.line("terminate %u", _processes[index].pid);
+    _commands++;
+    _live_bytes -= _processes[index].bytes;
+    _processes[index] = _processes.back();
+    _processes.pop_back();
+}
+
+/** Returns false, without writing anything, if the variable would take live data past --fill **/
+bool TraceGenerator::allocate(TraceProcess &proc)
+{
+    TraceVariable var;
+    var.type = (TraceType)pick(_config.type_weights, NUM_TYPES);
+    var.elements = sampleElements(var.type);
+    uint64_t bytes = (uint64_t)var.elements * type_sizes[var.type];
+    if (_live_bytes + bytes > _config.memory * _config.fill)
+    {
+        return false;
+    }
+    var.name = proc.next_name++;
+    _out.line("allocate %u v%u %s %u", proc.pid, var.name, type_names[var.type], var.elements);
+    _commands++;
+    proc.variables.push_back(var);
+    proc.bytes += bytes;
+    _live_bytes += bytes;
+    return true;
+}
+
+/** Frees one variable, picked by the free pattern. Checkerboard frees every other variable in allocation order,
+    leaving holes between survivors that later, larger allocations can't reuse **/
+void TraceGenerator::release(TraceProcess &proc)
+{
+    if (proc.variables.empty())
+    {
+        return;
+    }
+    size_t count = proc.variables.size();
+    size_t victim;
+    switch (_config.free_pattern)
+    {
+        case FreeFifo: victim = 0; break;
+        case FreeLifo: victim = count - 1; break;
+        case FreeCheckerboard: victim = (count >= 2) ? 1 + 2 * (_rng() % (count / 2)) : 0; break;
+        case FreeRandom:
+        default: victim = _rng() % count; break;
+    }
+
+    const TraceVariable &var = proc.variables[victim];
+    _out.line("free %u v%u", proc.pid, var.name);
+    _commands++;
+    uint64_t bytes = (uint64_t)var.elements * type_sizes[var.type];
+    proc.bytes -= bytes;
+    _live_bytes -= bytes;
+    proc.variables.erase(proc.variables.begin() + victim);
+}
+
+/** A variable drawn by Zipf rank, rank 1 being the newest **/
+const TraceVariable& TraceGenerator::accessed(TraceProcess &proc)
+{
+    uint32_t rank = _zipf.sample((uint32_t)proc.variables.size(), _rng);
+    return proc.variables[proc.variables.size() - rank];
+}
+
+void TraceGenerator::set(TraceProcess &proc, const TraceVariable &var)
+{
+    char values[512];
+    size_t length = 0;
+    uint32_t offset = (uint32_t)(_rng() % var.elements);
+    uint32_t count = 1 + (uint32_t)(_rng() % std::min<uint32_t>(var.elements - offset, 16));
+    for (uint32_t i = 0; i < count; i++)
+    {
+        switch (var.type)
+        {
+            case TypeChar: length += snprintf(values + length, sizeof(values) - length, " %c", 'a' + (int)(_rng() % 26)); break;
+            case TypeFloat:
+            case TypeDouble: length += snprintf(values + length, sizeof(values) - length, " %.3f", uniform() * 1000.0); break;
+            default: length += snprintf(values + length, sizeof(values) - length, " %d", (int)(_rng() % 20001) - 10000); break;
+        }
+    }
+    _out.line("set %u v%u %u%s", proc.pid, var.name, offset, values);
+    _commands++;
+}
+
+void TraceGenerator::run()
+{
+    while (_commands < _config.commands && (_config.bytes == 0 || _out.getWritten() < _config.bytes))
+    {
+        // Processes whose time has come go first
+        if (!_deaths.empty() && _deaths.top().first <= _commands)
+        {
+            size_t index = findProcess(_deaths.top().second);
+            _deaths.pop();
+            if (index < _processes.size())
+            {
+                terminate(index);
+            }
+            continue;
+        }
+
+        // Keep the process count up; the less full the table, the likelier a create
+        if (_processes.empty() || (_processes.size() < _config.max_processes &&
+            uniform() < 0.05 * (1.0 - (double)_processes.size() / _config.max_processes)))
+        {
+            uint64_t before = _commands;
+            create();
+            if (_commands == before && _processes.empty())
+            {
+                fprintf(stderr, "Error: a single process doesn't fit in --memory * --fill\n");
+                return;
+            }
+            continue;
+        }
+
+        const Phase &phase = known_phases[_config.phases[(_commands / _config.phase_length) % _config.phases.size()]];
+        size_t index = _rng() % _processes.size();
+        TraceProcess &proc = _processes[index];
+        TraceOp op = (TraceOp)pick(phase.weights, NUM_OPS);
+        if (proc.variables.empty() || (op == OpAllocate && proc.variables.size() < _config.max_variables)) {
+            // Out of room: make some instead, so the trace keeps moving without allocations failing
+            if (!allocate(proc))
+            {
+                if (proc.variables.empty()) {
+                    terminate(index);
+                } else {
+                    release(proc);
+                }
+            }
+        } else if (op == OpFree || op == OpAllocate) {
+            release(proc);
+        } else if (op == OpSet) {
+            set(proc, accessed(proc));
+        } else {
+            const TraceVariable &var = accessed(proc);
+            _out.line("print %u:v%u", proc.pid, var.name);
+            _commands++;
+        }
+    }
+
+    if (_config.terminate_all)
+    {
+        while (!_processes.empty())
+        {
+            terminate(_processes.size() - 1);
+        }
+    }
+}
+
+/** Parses a byte count with an optional K, M or G suffix (powers of 1024) **/
+bool parseSize(const char *text, uint64_t *size)
+{
+    char *end;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (end == text)
+    {
+        return false;
+    }
+    switch (*end) {
+        case 'K': case 'k': value <<= 10; end++; break;
+        case 'M': case 'm': value <<= 20; end++; break;
+        case 'G': case 'g': value <<= 30; end++; break;
+        default: break;
+    }
+    *size = value;
+    return *end == '\0';
+}
+
+int typeIndex(const std::string &name)
+{
+    for (int i = 0; i < NUM_TYPES; i++)
+    {
+        if (name == type_names[i]) { return i; }
+    }
+    return -1;
+}
+
+/** <type>=fixed:N | uniform:MIN:MAX | lognormal:MEDIAN:SIGMA | pareto:MIN:ALPHA **/
+bool parseSizeDistribution(const char *text, SizeDistribution *sizes)
+{
+    const char *equals = strchr(text, '=');
+    if (equals == NULL)
+    {
+        return false;
+    }
+    int type = typeIndex(std::string(text, equals - text));
+    char shape[16];
+    double a, b = 0.0;
+    int fields = sscanf(equals + 1, "%15[a-z]:%lf:%lf", shape, &a, &b);
+    if (type < 0 || fields < 2 || a <= 0)
+    {
+        return false;
+    }
+
+    SizeDistribution size = {SizeFixed, a, b};
+    std::string name = shape;
+    if (name == "fixed" && fields == 2) { size.shape = SizeFixed; }
+    else if (name == "uniform" && fields == 3 && b >= a) { size.shape = SizeUniform; }
+    else if (name == "lognormal" && fields == 3 && b > 0) { size.shape = SizeLognormal; }
+    else if (name == "pareto" && fields == 3 && b > 0) { size.shape = SizePareto; }
+    else { return false; }
+    sizes[type] = size;
+    return true;
+}
+
+/** char=30,int=40,... ; types left out get no weight **/
+bool parseTypeWeights(const char *text, double *weights)
+{
+    double parsed[NUM_TYPES] = {0};
+    std::string list = text;
+    size_t start = 0;
+    while (start < list.size())
+    {
+        size_t comma = list.find(',', start);
+        std::string item = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t equals = item.find('=');
+        int type = (equals == std::string::npos) ? -1 : typeIndex(item.substr(0, equals));
+        if (type < 0)
+        {
+            return false;
+        }
+        parsed[type] = atof(item.c_str() + equals + 1);
+        start = (comma == std::string::npos) ? list.size() : comma + 1;
+    }
+    double total = 0.0;
+    for (int i = 0; i < NUM_TYPES; i++) { total += parsed[i]; }
+    if (total <= 0)
+    {
+        return false;
+    }
+    memcpy(weights, parsed, sizeof(parsed));
+    return true;
+}
+
+bool parsePhases(const char *text, std::vector<uint32_t> &phases)
+{
+    phases.clear();
+    std::string list = text;
+    size_t start = 0;
+    while (start < list.size())
+    {
+        size_t comma = list.find(',', start);
+        std::string name = list.substr(start, comma == std::string::npos ? std::string::npos : comma - start);
+        size_t found = sizeof(known_phases) / sizeof(known_phases[0]);
+        for (size_t i = 0; i < sizeof(known_phases) / sizeof(known_phases[0]); i++)
+        {
+            if (name == known_phases[i].name) { found = i; }
+        }
+        if (found == sizeof(known_phases) / sizeof(known_phases[0]))
+        {
+            return false;
+        }
+        phases.push_back((uint32_t)found);
+        start = (comma == std::string::npos) ? list.size() : comma + 1;
+    }
+    return !phases.empty();
+}
+
+bool parseFreePattern(const std::string &name, FreePattern *pattern)
+{
+    if (name == "random") { *pattern = FreeRandom; }
+    else if (name == "fifo") { *pattern = FreeFifo; }
+    else if (name == "lifo") { *pattern = FreeLifo; }
+    else if (name == "checkerboard") { *pattern = FreeCheckerboard; }
+    else { return false; }
+    return true;
+}
+
+void printUsage(const char *program)
+{
+    fprintf(stderr, "usage: %s [options]\n", program);
+    fprintf(stderr, "  --seed N                 random seed (default 1)\n");
+    fprintf(stderr, "  --commands N             commands to generate (default 100000, or no limit with --bytes)\n");
+    fprintf(stderr, "  --bytes N[K|M|G]         stop once this much has been written\n");
+    fprintf(stderr, "  --output <file>          write the trace to a file instead of stdout\n");
+    fprintf(stderr, "  --processes N            processes alive at once (default 32)\n");
+    fprintf(stderr, "  --variables N            live variables per process (default 256)\n");
+    fprintf(stderr, "  --lifetime N             mean commands a process lives for, 0 for forever (default 20000)\n");
+    fprintf(stderr, "  --zipf S                 variable access skew, newest first; 0 for uniform (default 1.0)\n");
+    fprintf(stderr, "  --types T=W,...          data type mix (default char=25,short=5,int=30,long=10,float=10,double=20)\n");
+    fprintf(stderr, "  --size T=SHAPE:A[:B]     elements per variable of a type: fixed:N, uniform:MIN:MAX,\n");
+    fprintf(stderr, "                           lognormal:MEDIAN:SIGMA or pareto:MIN:ALPHA (repeatable)\n");
+    fprintf(stderr, "  --max-elements N         cap on elements per variable (default 65536)\n");
+    fprintf(stderr, "  --free random|fifo|lifo|checkerboard   which variable a free picks (default random)\n");
+    fprintf(stderr, "  --phases P,...           cycle through grow, steady, churn and shrink (default steady)\n");
+    fprintf(stderr, "  --phase-length N         commands per phase (default 50000)\n");
+    fprintf(stderr, "  --memory N[K|M|G]        memory of the target machine (default 64M)\n");
+    fprintf(stderr, "  --fill F                 share of memory live data may use (default 0.75)\n");
+    fprintf(stderr, "  --first-pid N            PID of the first create (default 1024)\n");
+    fprintf(stderr, "  --terminate-all          terminate every live process at the end\n");
+}
+
+int main(int argc, char **argv)
+{
+    TraceConfig config;
+    config.seed = 1;
+    config.commands = 100000;
+    config.bytes = 0;
+    config.max_processes = 32;
+    config.max_variables = 256;
+    config.lifetime = 20000;
+    config.zipf = 1.0;
+    config.memory = 64ULL << 20;
+    config.fill = 0.75;
+    config.first_pid = 1024;
+    config.max_elements = 65536;
+    config.free_pattern = FreeRandom;
+    config.phases.push_back(1);
+    config.phase_length = 50000;
+    config.terminate_all = false;
+    parseTypeWeights("char=25,short=5,int=30,long=10,float=10,double=20", config.type_weights);
+    // Strings, small integer arrays, and numeric arrays with a long tail of big ones
+    const SizeDistribution default_sizes[NUM_TYPES] = {
+        {SizeLognormal, 32, 1.0}, {SizeUniform, 1, 64}, {SizeLognormal, 16, 1.5},
+        {SizeLognormal, 8, 1.5}, {SizeLognormal, 64, 1.0}, {SizePareto, 4, 1.2}
+    };
+    memcpy(config.sizes, default_sizes, sizeof(default_sizes));
+    const char *output_path = NULL;
+    bool commands_given = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        bool ok = true;
+        if (option == "--seed" && i + 1 < argc) {
+            config.seed = strtoull(argv[++i], NULL, 10);
+        } else if (option == "--commands" && i + 1 < argc) {
+            config.commands = strtoull(argv[++i], NULL, 10);
+            commands_given = true;
+        } else if (option == "--bytes" && i + 1 < argc) {
+            ok = parseSize(argv[++i], &config.bytes);
+        } else if (option == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (option == "--processes" && i + 1 < argc) {
+            config.max_processes = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--variables" && i + 1 < argc) {
+            config.max_variables = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--lifetime" && i + 1 < argc) {
+            config.lifetime = atof(argv[++i]);
+        } else if (option == "--zipf" && i + 1 < argc) {
+            config.zipf = atof(argv[++i]);
+        } else if (option == "--types" && i + 1 < argc) {
+            ok = parseTypeWeights(argv[++i], config.type_weights);
+        } else if (option == "--size" && i + 1 < argc) {
+            ok = parseSizeDistribution(argv[++i], config.sizes);
+        } else if (option == "--max-elements" && i + 1 < argc) {
+            config.max_elements = std::max(1UL, strtoul(argv[++i], NULL, 10));
+        } else if (option == "--free" && i + 1 < argc) {
+            ok = parseFreePattern(argv[++i], &config.free_pattern);
+        } else if (option == "--phases" && i + 1 < argc) {
+            ok = parsePhases(argv[++i], config.phases);
+        } else if (option == "--phase-length" && i + 1 < argc) {
+            config.phase_length = std::max(1ULL, strtoull(argv[++i], NULL, 10));
+        } else if (option == "--memory" && i + 1 < argc) {
+            ok = parseSize(argv[++i], &config.memory) && config.memory > 0;
+        } else if (option == "--fill" && i + 1 < argc) {
+            config.fill = atof(argv[++i]);
+            ok = config.fill > 0 && config.fill <= 1;
+        } else if (option == "--first-pid" && i + 1 < argc) {
+            config.first_pid = strtoul(argv[++i], NULL, 10);
+        } else if (option == "--terminate-all") {
+            config.terminate_all = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Error: invalid value '%s' for %s\n", argv[i], option.c_str());
+            return 1;
+        }
+    }
+
+    // A byte budget on its own sets the length of the trace
+    if (config.bytes > 0 && !commands_given)
+    {
+        config.commands = UINT64_MAX;
+    }
+
+    FILE *output = stdout;
+    if (output_path != NULL)
+    {
+        output = fopen(output_path, "w");
+        if (output == NULL)
+        {
+            fprintf(stderr, "Error: cannot create '%s'\n", output_path);
+            return 1;
+        }
+    }
+
+    {
+        TraceWriter writer(output);
+        // memsim skips comment lines, so the trace can carry the command line that reproduces it
+        std::string command_line;
+        for (int i = 1; i < argc; i++) { command_line += std::string(" ") + argv[i]; }
+        writer.line("# tracegen%s (seed %llu)", command_line.c_str(), (unsigned long long)config.seed);
+
+        TraceGenerator generator(config, writer);
+        generator.run();
+    }
+
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}